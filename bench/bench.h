@@ -0,0 +1,37 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <algorithm>
+
+/// Timings of what the compiler was made faster at, each against what
+/// it replaced where that can still be built
+
+/// fyrec-bench runs them all, or those named on its command line. Their
+/// inputs are generated, so every run times the same thing. Only a build
+/// with optimizations says anything.
+namespace Bench {
+  /// The best time of `runs` calls of `fn`, in milliseconds
+  template<class Fn>
+  double best_ms(Fn fn, int runs = 10) {
+    using clock = std::chrono::steady_clock;
+
+    double best = 0;
+    for (int i = 0; i < runs; i++) {
+      auto start = clock::now();
+      fn();
+      std::chrono::duration<double, std::milli> t = clock::now() - start;
+      best = i == 0 ? t.count() : std::min(best, t.count());
+    }
+    return best;
+  }
+
+  /// Print a timing as a line of the benchmark running
+  void report(const char *what, double ms);
+
+  void scan();
+  void grammar();
+  void cache();
+}
+
+#endif
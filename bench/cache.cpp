@@ -0,0 +1,59 @@
+#include <string>
+#include <fstream>
+#include <cstdio>
+
+#include "bench.h"
+
+#include "fyre/AST.h"
+#include "fyre/flat.h"
+#include "fyre/cache.h"
+#include "parser/parser.h"
+#include "parser/lexer.h"
+
+namespace Bench {
+  void cache() {
+    // a module of about 1MB, written to the current directory for the
+    // cache to be next to
+    std::string file = "fyrec-bench.fy";
+    {
+      std::ofstream os(file);
+      os << "add(a Int, b Int) Int;\n";
+      for (int i = 0; i < 20000; i++)
+        os << "f" << i << "(x Int, y Int) Int = add(x, add(y, " << i
+           << "));\n";
+    }
+    std::string path = Fyre::Cache::path(file);
+
+    Fyre::ModulePtr module;
+    report("Module::parse", best_ms([&] {
+      Parser::IParseStream in(file);
+      Parser::ParseCursor cur = in.cursor();
+      Parser::TokenCursor toks(cur);
+      module = *toks.one_of<Fyre::Module>();
+    }));
+
+    std::unique_ptr<Fyre::FlatModule> flat;
+    report("FlatModule from it", best_ms([&] {
+      flat = std::make_unique<Fyre::FlatModule>(*module);
+    }));
+
+    {
+      Parser::IParseStream in(file);
+      Fyre::Cache::store(path, Fyre::Cache::key(in.lrdbuf()->mapping()),
+                         *flat);
+    }
+
+    // what a hit takes instead of both
+    bool hit = true;
+    report("Cache::key + Cache::load", best_ms([&] {
+      Parser::IParseStream in(file);
+      uint64_t key = Fyre::Cache::key(in.lrdbuf()->mapping());
+      hit = hit && Fyre::Cache::load(path, key) != nullptr;
+    }));
+    if (!hit)
+      std::printf("  (missed the cache)\n");
+
+    std::remove(file.c_str());
+    std::remove(path.c_str());
+  }
+}
@@ -0,0 +1,70 @@
+#include <string>
+#include <functional>
+
+#include "bench.h"
+
+#include "parser/parser.h"
+#include "parser/grammar.h"
+
+namespace Bench {
+  namespace {
+    using Parser::CharSet;
+    using Parser::ParseCursor;
+
+    constexpr CharSet lparen = {'('};
+    constexpr CharSet rparen = {')'};
+    constexpr CharSet comma  = {','};
+    constexpr CharSet letter = {'a'};
+
+    // how every rule was called before the grammar was made of types,
+    // through a static std::function
+    template<class P>
+    struct Indirect {
+      using R = decltype(P::parse(std::declval<ParseCursor &>()));
+      static const std::function<R(ParseCursor &)> parser;
+
+      static R parse(ParseCursor &in) { return parser(in); }
+    };
+
+    template<class P>
+    const std::function<typename Indirect<P>::R(ParseCursor &)>
+    Indirect<P>::parser = [](ParseCursor &in) { return P::parse(in); };
+
+    template<const CharSet &S>
+    using Char = Parser::Char<S>;
+
+    using Direct = Parser::Enclosed<Char<lparen>,
+                                    Parser::SepBy<Char<letter>, Char<comma>>,
+                                    Char<rparen>>;
+
+    using Functions =
+      Indirect<Parser::Enclosed<
+                 Indirect<Char<lparen>>,
+                 Indirect<Parser::SepBy<Indirect<Char<letter>>,
+                                        Indirect<Char<comma>>>>,
+                 Indirect<Char<rparen>>>>;
+
+    // parse all of `src` as G after G
+    template<class G>
+    double parse_all(const std::string &src) {
+      volatile size_t n;
+
+      return best_ms([&] {
+        ParseCursor in(src.data(), src.data() + src.size());
+        size_t elems = 0;
+        while (in.peek() != EOF)
+          elems += in.one_of<G>()->size();
+        n = elems;
+      });
+    }
+  }
+
+  void grammar() {
+    std::string src;
+    for (int i = 0; i < 200000; i++)
+      src += "(a,a,a,a,a,a,a,a)";
+
+    report("std::function rules", parse_all<Functions>(src));
+    report("grammar.h templates", parse_all<Direct>(src));
+  }
+}
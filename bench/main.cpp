@@ -0,0 +1,34 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+#include "bench.h"
+
+namespace Bench {
+  void report(const char *what, double ms) {
+    std::printf("  %-32s %9.2fms\n", what, ms);
+  }
+}
+
+// fyrec-bench [name...]
+int main(int argc, char **argv) {
+  struct {
+    const char *name;
+    void (*run)();
+  } benches[] = {
+    { "scan",    Bench::scan    },
+    { "grammar", Bench::grammar },
+    { "cache",   Bench::cache   },
+  };
+
+  for (auto &bench : benches) {
+    bool named = argc == 1;
+    for (int i = 1; i < argc; i++)
+      named = named || std::strcmp(argv[i], bench.name) == 0;
+
+    if (named) {
+      std::cout << bench.name << ":" << std::endl;
+      bench.run();
+    }
+  }
+}
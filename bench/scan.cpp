@@ -0,0 +1,41 @@
+#include <string>
+
+#include "bench.h"
+
+#include "parser/scan.h"
+
+namespace Bench {
+  namespace {
+    constexpr Parser::CharSet word =
+      Parser::CharSet('_', Parser::CharSet::range('a', 'z', "lower-case"),
+                           Parser::CharSet::range('A', 'Z', "upper-case"),
+                           Parser::CharSet::range('0', '9', "digit"));
+  }
+
+  void scan() {
+    // one word of 64MiB, the worst case of a byte at a time
+    std::string src(64 << 20, 'a');
+    src.back() = ' ';
+    const char *beg = src.data(), *end = beg + src.size();
+
+    volatile size_t n;
+
+    // what the cursors did before spans: append byte by byte
+    report("std::string append", best_ms([&] {
+      std::string word_of;
+      for (const char *c = beg; word.contains(*c); c++)
+        word_of += *c;
+      n = word_of.size();
+    }, 3));
+
+    report("Scan::span_scalar", best_ms([&] {
+      n = Parser::Scan::span_scalar(word, beg, end) - beg;
+    }, 3));
+
+    report("Scan::span", best_ms([&] {
+      n = Parser::Scan::span(word, beg, end) - beg;
+    }, 3));
+
+    (void)n;
+  }
+}
@@ -0,0 +1,77 @@
+#include <cassert>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <sstream>
+
+#include "check.h"
+
+#include "parser/arena.h"
+#include "parser/small_vector.h"
+#include "parser/symbols.h"
+
+// every allocation of fyrec-check is counted
+static std::atomic<size_t> allocations(0);
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace Check {
+  namespace {
+    // how many allocations `fn` makes
+    template<class Fn>
+    size_t allocs(Fn fn) {
+      size_t before = allocations;
+      fn();
+      return allocations - before;
+    }
+
+    // a module of n definitions, of a few names, each with two calls
+    std::string module(size_t n) {
+      std::stringstream ss;
+      ss << "add(a Int, b Int) Int;\n";
+      for (size_t i = 0; i < n; i++)
+        ss << "f" << i % 50 << "(x Int, y Int) Int = add(x, add(y, 1));\n";
+      return ss.str();
+    }
+  }
+
+  void alloc() {
+    // nodes come out of a few blocks, that grow
+    Parser::Arena arena;
+    size_t n = allocs([&] {
+      for (size_t i = 0; i < 100000; i++)
+        arena.make<Fyre::IntLit>(i);
+    });
+    assert(n < 32);
+
+    // short lists stay inline
+    n = allocs([] {
+      Parser::SmallVector<Fyre::ExprPtr, 4> args;
+      for (size_t i = 0; i < 4; i++)
+        args.push_back(nullptr);
+    });
+    assert(n == 0);
+
+    // a known name is only looked up
+    Parser::Symbols::intern("known");
+    n = allocs([] { Parser::Symbols::intern("known"); });
+    assert(n == 0);
+
+    // and all that adds up to a few allocations per definition, which
+    // took 48 when parse results were copied and argument lists were
+    // vectors of their own. The difference between two sizes leaves out
+    // what every parse allocates once.
+    std::string a = module(1000), b = module(2000);
+    size_t small = allocs([&] { parse(a); });
+    size_t large = allocs([&] { parse(b); });
+    assert(large - small < 16 * 1000);
+  }
+}
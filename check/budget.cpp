@@ -0,0 +1,105 @@
+#include <cassert>
+#include <fstream>
+#include <iterator>
+
+#include "check.h"
+
+#include "parser/parser.h"
+#include "parser/lexer.h"
+#include "parser/exceptions.h"
+
+namespace Check {
+  namespace {
+    // parse `file` with `budget` as fyrec does, giving what it took and
+    // whether it gave up because of the budget
+    bool exceeds(const std::string &file, const Parser::Budget &budget,
+                 Parser::ParseStats *stats = nullptr) {
+      std::ifstream is(file);
+      assert(is);
+      Parser::IParseStream in(is);
+      Parser::ParseCursor cur = in.cursor();
+      Parser::TokenCursor toks(cur);
+      cur.set_budget(budget);
+      toks.set_budget(budget);
+
+      bool exceeded = false;
+      try {
+        toks.one_of<Fyre::Module>();
+      } catch (Parser::BudgetExceeded &) {
+        exceeded = true;
+      }
+
+      if (stats)
+        *stats = toks.stats();
+      return exceeded;
+    }
+
+    // the same on `jobs` threads
+    bool exceeds_parallel(const std::string &file,
+                          const Parser::Budget &budget, unsigned jobs,
+                          Parser::ParseStats *stats = nullptr) {
+      Parser::IParseStream in(file);
+      Parser::ParseCursor cur = in.cursor();
+      cur.set_budget(budget);
+
+      bool exceeded = false;
+      try {
+        Fyre::Module::parse_parallel(cur, jobs);
+      } catch (Parser::BudgetExceeded &) {
+        exceeded = true;
+      }
+
+      if (stats)
+        *stats = cur.stats();
+      return exceeded;
+    }
+  }
+
+  void budget() {
+    // inputs that backtrack a lot: many statements that each get far
+    // into the wrong alternative, long ones that rewind over many
+    // bytes, and nesting that never closes
+    for (auto name : { "decls.fy", "wide.fy", "unclosed.fy" }) {
+      std::string file = inputs + "/budget/" + name;
+
+      Parser::ParseStats stats;
+      assert(!exceeds(file, {}, &stats));
+      assert(stats.rewinds > 1 && stats.rescanned > 1);
+
+      // -r: half the rewinds it takes
+      Parser::Budget rewinds;
+      rewinds.rewinds = stats.rewinds / 2;
+      assert(exceeds(file, rewinds));
+
+      // -b: half the bytes it goes back over
+      Parser::Budget rescanned;
+      rescanned.rescanned = stats.rescanned / 2;
+      assert(exceeds(file, rescanned));
+
+      // -t: a deadline that's passed, so this doesn't depend on how fast
+      // the machine is
+      Parser::Budget deadline;
+      deadline.deadline = std::chrono::steady_clock::now();
+      assert(exceeds(file, deadline));
+    }
+
+    // on several threads the budget is for all of them together, the
+    // pieces of this one each rewind far less than the whole may
+    std::string file = inputs + "/budget/decls.fy";
+    Parser::ParseStats stats;
+    assert(!exceeds(file, {}, &stats));
+
+    std::ifstream is(file);
+    std::string src((std::istreambuf_iterator<char>(is)),
+                    std::istreambuf_iterator<char>());
+    assert(Fyre::Module::split(src, 8 * 4).size() > 8);
+
+    Parser::ParseStats parallel;
+    assert(!exceeds_parallel(file, {}, 8, &parallel));
+    assert(parallel.rewinds == stats.rewinds);
+
+    Parser::Budget rewinds;
+    rewinds.rewinds = stats.rewinds / 4;
+    assert(exceeds_parallel(file, rewinds, 8));
+  }
+}
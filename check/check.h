@@ -0,0 +1,35 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <string>
+#include <istream>
+
+#include "fyre/AST.h"
+
+/// Checks of how the compiler behaves, each asserting what it checks
+
+/// fyrec-check runs them all. It runs from the top of the tree, so
+/// inputs are found in check/inputs.
+namespace Check {
+  /// Where the inputs of the checks are
+  extern std::string inputs;
+
+  /// What parsing `in` as a Module throws, empty if it parses
+  std::string parse_error(std::istream &in);
+  std::string parse_error(const std::string &src);
+  /// `src` parsed as a Module, which it must be
+  Fyre::ModulePtr parse(const std::string &src);
+
+  bool contains(const std::string &s, const std::string &part);
+
+  void errors();
+  void share();
+  void split();
+  void parallel();
+  void reparse();
+  void budget();
+  void deep();
+  void alloc();
+}
+
+#endif
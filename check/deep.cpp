@@ -0,0 +1,45 @@
+#include <cassert>
+
+#include "check.h"
+
+namespace Check {
+  namespace {
+    // how deep the operands of `e` go, following the last of each
+    size_t depth(const Fyre::Expr &e) {
+      size_t n = 0;
+      for (const Fyre::Expr *p = &e; p->operands() > 0;
+           p = &p->operand(p->operands() - 1))
+        n++;
+      return n;
+    }
+
+    // the body of the definition that ends `src`
+    size_t body_depth(const std::string &src) {
+      auto module = parse(src);
+      auto def = dynamic_cast<Fyre::FunDefPtr>(module->statements().back());
+      assert(def);
+      return depth(*def->expr());
+    }
+
+    std::string repeat(const std::string &s, size_t n) {
+      std::string r;
+      r.reserve(s.size() * n);
+      for (size_t i = 0; i < n; i++)
+        r += s;
+      return r;
+    }
+  }
+
+  void deep() {
+    // far deeper than any stack would hold a frame per level
+    constexpr size_t n = 1000000;
+    std::string head = "g(a Int) Int;\nf(x Int) Int = ";
+
+    // calls
+    assert(body_depth(head + repeat("g(", n) + "x" + repeat(")", n)) == n);
+    // operands in parens
+    assert(body_depth(head + repeat("x + (", n) + "x" + repeat(")", n)) == n);
+    // and parens alone, which leave nothing behind
+    assert(body_depth(head + repeat("(", n) + "x" + repeat(")", n)) == 0);
+  }
+}
@@ -0,0 +1,23 @@
+#include <cassert>
+
+#include "check.h"
+
+namespace Check {
+  void errors() {
+    std::string e;
+
+    // the farthest failure is where FunDef got to, past where the FunDec
+    // that did parse was committed
+    e = parse_error("f(x Int) Int = g(x,\n  1 +)");
+    assert(contains(e, " at 2:5 "));
+    assert(contains(e, "Got: ')'"));
+
+    e = parse_error("f() Int = 99999999999999999999;\n");
+    assert(contains(e, " at 1:10 "));
+    assert(contains(e, "Integer literal out of range: 99999999999999999999"));
+
+    // and one that's only before a commit doesn't outlive it
+    e = parse_error("f(x Int) Int = x;\ng(y Int) Int = ;\n");
+    assert(contains(e, " at 2:15 "));
+  }
+}
@@ -0,0 +1,74 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+#include "check.h"
+
+#include "fyre/AST.h"
+#include "parser/parser.h"
+#include "parser/lexer.h"
+#include "parser/exceptions.h"
+
+namespace Check {
+  std::string inputs = "check/inputs";
+
+  std::string parse_error(std::istream &is) {
+    Parser::IParseStream in(is);
+    Parser::ParseCursor cur = in.cursor();
+    Parser::TokenCursor toks(cur);
+
+    try {
+      if (!toks.one_of<Fyre::Module>())
+        return toks.error().what();
+    } catch (Parser::Error &e) {
+      return e.what();
+    }
+    return "";
+  }
+
+  std::string parse_error(const std::string &src) {
+    std::stringstream ss(src);
+    return parse_error(ss);
+  }
+
+  Fyre::ModulePtr parse(const std::string &src) {
+    std::stringstream ss(src);
+    Parser::IParseStream in(ss);
+    Parser::ParseCursor cur = in.cursor();
+    Parser::TokenCursor toks(cur);
+
+    auto r = toks.one_of<Fyre::Module>();
+    assert(r);
+    return *r;
+  }
+
+  bool contains(const std::string &s, const std::string &part) {
+    return s.find(part) != std::string::npos;
+  }
+}
+
+// fyrec-check [inputs]
+int main(int argc, char **argv) {
+  if (argc > 1)
+    Check::inputs = argv[1];
+
+  struct {
+    const char *name;
+    void (*run)();
+  } checks[] = {
+    { "errors",   Check::errors    },
+    { "share",    Check::share     },
+    { "split",    Check::split     },
+    { "parallel", Check::parallel  },
+    { "reparse",  Check::reparse   },
+    { "budget",   Check::budget    },
+    { "deep",     Check::deep      },
+    { "alloc",    Check::alloc     },
+  };
+
+  for (auto &check : checks) {
+    std::cout << check.name << "... " << std::flush;
+    check.run();
+    std::cout << "ok" << std::endl;
+  }
+}
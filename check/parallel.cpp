@@ -0,0 +1,90 @@
+#include <cassert>
+#include <sstream>
+
+#include "check.h"
+#include "fyre/printer.h"
+
+#include "parser/parser.h"
+#include "parser/lexer.h"
+#include "parser/exceptions.h"
+
+namespace Check {
+  namespace {
+    // `src` parsed one statement after the other, or what it throws
+    Fyre::ModulePtr sequential(const std::string &src, std::string &error) {
+      Parser::ParseCursor cur(src.data(), src.data() + src.size());
+      Parser::TokenCursor toks(cur);
+
+      auto r = toks.one_of<Fyre::Module>();
+      if (!r) {
+        error = toks.error().what();
+        return nullptr;
+      }
+      return *r;
+    }
+
+    // and in pieces, on `jobs` threads
+    Fyre::ModulePtr parallel(const std::string &src, unsigned jobs,
+                             std::string &error) {
+      Parser::ParseCursor cur(src.data(), src.data() + src.size());
+
+      try {
+        return Fyre::Module::parse_parallel(cur, jobs);
+      } catch (Parser::Error &e) {
+        error = e.what();
+        return nullptr;
+      }
+    }
+
+    std::string source(const Fyre::TopLvl &stmnt) {
+      std::stringstream ss;
+      Fyre::SourcePrinter(ss).print(stmnt);
+      return ss.str();
+    }
+
+    // a statement per line, bodies going on over the next, and `bad`
+    // in place of the body of the statement `at`
+    std::string module(size_t n, size_t at = -1,
+                       const std::string &bad = "") {
+      std::stringstream ss;
+      ss << "add(a Int, b Int) Int\n";
+      for (size_t i = 0; i < n; i++) {
+        ss << "f" << i << "(x Int) Int = ";
+        if (i == at)
+          ss << bad << "\n";
+        else
+          ss << "add(x,\n    " << i << ") *\n  (x + " << i << ")\n";
+      }
+      return ss.str();
+    }
+  }
+
+  void parallel() {
+    std::string src = module(64), error;
+    assert(Fyre::Module::split(src, 4 * 4).size() > 2);
+
+    // the same statements where they were
+    auto seq = sequential(src, error);
+    auto par = parallel(src, 4, error);
+    assert(seq && par);
+
+    assert(par->statements().size() == seq->statements().size());
+    for (size_t i = 0; i < seq->statements().size(); i++) {
+      auto &a = seq->spans()[i], &b = par->spans()[i];
+      assert(a.offset == b.offset && a.length == b.length &&
+             a.reach == b.reach);
+      assert(source(*par->statements()[i]) ==
+             source(*seq->statements()[i]));
+    }
+
+    // an error in a later piece is where it is in the whole input
+    src = module(64, 50, "x * * 2");
+    size_t piece = Fyre::Module::split(src, 4 * 4)[1];
+    assert(src.find("x * * 2") > piece);
+
+    std::string seq_error, par_error;
+    assert(!sequential(src, seq_error) && !parallel(src, 4, par_error));
+    assert(contains(seq_error, " at 152:21 "));
+    assert(par_error == seq_error);
+  }
+}
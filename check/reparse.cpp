@@ -0,0 +1,121 @@
+#include <cassert>
+#include <sstream>
+
+#include "check.h"
+#include "fyre/printer.h"
+
+#include "parser/exceptions.h"
+#include "parser/location.h"
+
+namespace Check {
+  namespace {
+    using Edit = Fyre::Module::Edit;
+
+    std::string source(const Fyre::TopLvl &stmnt) {
+      std::stringstream ss;
+      Fyre::SourcePrinter(ss).print(stmnt);
+      return ss.str();
+    }
+
+    // `src` with `edit` made to it
+    std::string edited(const std::string &src, const Edit &edit) {
+      return src.substr(0, edit.offset) + std::string(edit.inserted) +
+             src.substr(edit.offset + edit.removed);
+    }
+
+    // `text` put in place of `what`, the first after `after`
+    Edit replace(const std::string &src, const std::string &what,
+                 std::string_view text, const std::string &after = "") {
+      size_t at = src.find(what, src.find(after) + after.size());
+      assert(at != std::string::npos);
+      return { (uint32_t)at, (uint32_t)what.size(), text };
+    }
+
+    // reparse `module`, made from `src`, after `edit` and check it's what
+    // parsing the new source gives, spans and all
+    Fyre::ModulePtr same(const Fyre::ModulePtr &module,
+                         const std::string &src, const Edit &edit) {
+      std::string next = edited(src, edit);
+      auto r = module->reparse(next, edit);
+      auto fresh = parse(next);
+
+      assert(r->statements().size() == fresh->statements().size());
+      for (size_t i = 0; i < fresh->statements().size(); i++) {
+        auto &a = r->spans()[i], &b = fresh->spans()[i];
+        assert(a.offset == b.offset && a.length == b.length &&
+               a.reach == b.reach);
+        assert(source(*r->statements()[i]) ==
+               source(*fresh->statements()[i]));
+      }
+      return r;
+    }
+  }
+
+  void reparse() {
+    std::string src =
+      "add(a Int, b Int) Int\n"
+      "f(x Int) Int = add(x, 1)\n"
+      "g(y Int) Int = f(y) * 2;\n"
+      "m(v Int) Int = v\n"
+      "h(z Int) Int = g(z) + f(z)";
+    auto module = parse(src);
+
+    std::vector<Edit> edits = {
+      // inside a statement
+      replace(src, "1", "42", "f(x"),
+      // between statements
+      replace(src, "", "k(w Int) Int = w\n", ";\n"),
+      // onto the last token of the statement before, `v` + `oo`
+      replace(src, "", "oo", "m(v Int) Int = v"),
+      // two statements made one
+      replace(src, ";\nm(v Int) Int = ", " + ", "f(y) * 2"),
+      // one made two
+      replace(src, "", "\nn(q Int) Int = q", "f(y)"),
+      // a statement gone
+      replace(src, "m(v Int) Int = v\n", ""),
+      // at the end, onto the last statement and after it
+      { (uint32_t)src.size(), 0, " * 3" },
+      { (uint32_t)src.size(), 0, "\np(a Int) Int = a" },
+      // and the last statement gone
+      replace(src, src.substr(src.find("\nh(")), ""),
+    };
+
+    for (auto &edit : edits)
+      same(module, src, edit);
+
+    // one after the other, as in an editor
+    struct {
+      const char *what, *text, *after;
+    } typed[] = {
+      { "",  "j",                "m(v Int) Int = v\n" },
+      { "",  "(i Int) Int = i\n", "\nj" },
+      { "i", "i + 1",            "j(i Int) Int = " },
+      { "1)", "12)",             "add(x, " },
+      { "",  " * 2",             "+ f(z)" },
+    };
+    for (auto &t : typed) {
+      Edit edit = replace(src, t.what, t.text, t.after);
+      module = same(module, src, edit);
+      src = edited(src, edit);
+    }
+
+    // an edit that doesn't parse shows where in the new source, and
+    // only that goes in the file table
+    Edit edit = replace(src, "12", "13");
+    std::string next = edited(src, edit);
+    uint32_t before = Parser::Files::add("-");
+    for (int i = 0; i < 100; i++)
+      module->reparse(next, edit);
+    assert(Parser::Files::add("-") == before + 1);
+
+    Edit bad = replace(src, "v\n", "v +\n");
+    next = edited(src, bad);
+    std::string e;
+    try {
+      module->reparse(next, bad);
+    } catch (Parser::Error &err) {
+      e = err.what();
+    }
+    assert(!e.empty() && e == parse_error(next));
+  }
+}
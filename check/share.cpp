@@ -0,0 +1,45 @@
+#include <cassert>
+#include <sstream>
+
+#include "check.h"
+#include "fyre/printer.h"
+
+namespace Check {
+  namespace {
+    std::string source(const Fyre::Module &module) {
+      std::stringstream ss;
+      Fyre::SourcePrinter(ss).print(module);
+      return ss.str();
+    }
+
+    bool any_shared(const Fyre::Expr &e) {
+      for (size_t i = 0; i < e.operands(); i++)
+        if (any_shared(e.operand(i)))
+          return true;
+      return e.shared();
+    }
+
+    // whether share() found any node of `module` more than once
+    bool any_shared(const Fyre::Module &module) {
+      for (auto stmnt : module.statements())
+        if (auto def = dynamic_cast<Fyre::FunDefPtr>(stmnt))
+          if (any_shared(*def->expr()))
+            return true;
+      return false;
+    }
+  }
+
+  void share() {
+    auto module = parse("f(x Int) Int = (x + 1) * (x + 1);\n"
+                        "g(x Int) Int = f(x + 1) + f(x + 1);\n");
+    std::string before = source(*module);
+
+    auto shared = module->share();
+    assert(source(*shared) == before);
+    assert(any_shared(*shared));
+
+    // the module shared from is left as it was
+    assert(source(*module) == before);
+    assert(!any_shared(*module));
+  }
+}
@@ -0,0 +1,39 @@
+#include <cassert>
+#include <sstream>
+
+#include "check.h"
+
+namespace Check {
+  namespace {
+    // how many pieces parse_parallel() would parse `src` in
+    size_t pieces(const std::string &src, size_t n) {
+      auto cuts = Fyre::Module::split(src, n);
+      for (size_t i = 1; i < cuts.size(); i++)
+        assert(cuts[i - 1] < cuts[i]);
+      assert(cuts.back() == src.size());
+      return cuts.size() - 1;
+    }
+  }
+
+  void split() {
+    // a statement per line, with no `;` between them
+    std::stringstream ss;
+    ss << "add(a Int, b Int) Int\n";
+    for (int i = 0; i < 64; i++)
+      ss << "f" << i << "(x Int) Int = add(x,\n    " << i << ") +\n"
+         << "  g(x)\n";
+    std::string src = ss.str();
+
+    size_t n = pieces(src, 8);
+    assert(n > 1);
+
+    // and each piece starts a statement
+    auto cuts = Fyre::Module::split(src, 8);
+    for (size_t i = 1; i + 1 < cuts.size(); i++)
+      assert(src[cuts[i]] == 'f');
+
+    // nothing's cut where a call or an operator goes on to the next line
+    assert(pieces("f(x Int) Int = x +\ng(x)\n", 64) == 1);
+    assert(pieces("f(x Int) Int =\ng(x)\n", 64) == 1);
+  }
+}
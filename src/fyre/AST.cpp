@@ -1,156 +1,107 @@
 #include <sstream>
+#include <stdexcept>
 
 #include "AST.h"
+#include "printer.h"
+
+#include <parser/symbols.h>
 
 namespace Fyre {
   std::ostream &operator<<(std::ostream &os, ANode const &id) {
-    return os << id.to_string();
+    id.print(os);
+    return os;
   }
 
 
-  Ident::Ident(std::string ident) : m_str(ident) {}
+  Ident::Ident(Parser::Symbol ident) : m_symbol(ident) {}
 
-  std::string Ident::to_string() const { return m_str; }
+  std::string Ident::to_string() const {
+    return std::string(Parser::Symbols::str(m_symbol));
+  }
   std::string Ident::str() const { return to_string(); }
 
-  Type::Type(std::string type, std::vector<TypePtr> args)
-    : m_str(type), m_args(args) {}
+  Type::Type(Parser::Symbol type, Args args)
+    : m_symbol(type), m_args(args) {}
 
   std::string Type::to_string() const {
     std::stringstream r;
-
-    r << m_str;
-    for (auto &arg : m_args)
-      r << ".(" << arg << ")";
-
+    print(r);
     return r.str();
   }
 
-  IntLit::IntLit(long long int val) : m_val(val) {}
-  std::string IntLit::to_string() const {
-    return std::to_string(m_val);
+  void Type::print(std::ostream &os) const {
+    SourcePrinter(os).print(*this);
   }
 
-  Var::Var(IdentPtr name) : m_name(name) {}
-  std::string Var::to_string() const {
-    return m_name->to_string();
+  std::string TopLvl::to_string() const {
+    std::stringstream r;
+    print(r);
+    return r.str();
   }
 
-  FunDec::FunDec(IdentPtr name, std::vector<Arg> args,
-                 TypePtr type, std::optional<TypePtr> context)
-    : m_name(name), m_args(args),
-      m_type(type), m_context(context) {}
-
-  std::ostream &operator<<(std::ostream &os, FunDec::Arg const &arg) {
-    if (arg.name)
-      os << *arg.name << " ";
-    os << arg.type;
-    return os;
+  void TopLvl::print(std::ostream &os) const {
+    SourcePrinter(os).print(*this);
   }
 
-  std::string FunDec::to_string() const {
+  std::string Expr::to_string() const {
     std::stringstream r;
+    print(r);
+    return r.str();
+  }
 
-    r << m_name
-      << "(";
+  void Expr::print(std::ostream &os) const {
+    SourcePrinter(os).print(*this);
+  }
 
-    for (auto &arg : m_args) {
-      r << arg;
-      if (&arg < &m_args.back())
-        r << ", ";
-    }
+  const Expr &Expr::operand(size_t i) const {
+    throw std::out_of_range("Expression has no operand " + std::to_string(i));
+  }
 
-    r << ") "
-      << m_type;
+  IntLit::IntLit(long long int val) : m_val(val) {}
 
-    if (m_context)
-      r << " : "
-        << *m_context;
+  Var::Var(IdentPtr name) : m_name(std::move(name)) {}
 
-    return r.str();
-  }
+  FunDec::FunDec(IdentPtr name, Args args,
+                 TypePtr type, std::optional<TypePtr> context)
+    : m_name(std::move(name)), m_args(std::move(args)),
+      m_type(std::move(type)), m_context(std::move(context)) {}
 
   std::string FunDec::name_str() const {
     return m_name->str();
   }
 
-  FunDef::FunDef(IdentPtr name, std::vector<Arg> args,
+  FunDef::FunDef(IdentPtr name, Args args,
                  TypePtr type, std::optional<TypePtr> context,
                  ExprPtr expr)
-    : m_name(name), m_args(args),
-      m_type(type), m_context(context),
-      m_expr(expr) {}
-
-  std::ostream &operator<<(std::ostream &os, FunDef::Arg const &arg) {
-    os << arg.name;
-
-    if (arg.type)
-      os << " " << *arg.type;
-
-    return os;
-  }
-
-  std::string FunDef::to_string() const {
-    std::stringstream r;
-
-    r << m_name
-      << "(";
-
-    for (auto &arg : m_args) {
-      r << arg;
-    if (&arg < &m_args.back())
-      r << ", ";
-    }
-
-    r << ") "
-      << m_type;
-
-    if (m_context)
-      r << " : "
-        << *m_context;
-
-    r << " = "
-      << m_expr;
-
-    return r.str();
-  }
+    : m_name(std::move(name)), m_args(std::move(args)),
+      m_type(std::move(type)), m_context(std::move(context)),
+      m_expr(std::move(expr)) {}
 
   std::string FunDef::name_str() const {
     return m_name->str();
   }
 
-  FunCal::FunCal(IdentPtr name, std::vector<Arg> args)
-    : m_name(name), m_args(args) {}
+  FunCal::FunCal(IdentPtr name, Args args)
+    : m_name(std::move(name)), m_args(std::move(args)) {}
 
-  std::string FunCal::to_string() const {
-    std::stringstream r;
-
-    r << m_name
-      << "(";
-
-    for (auto &arg : m_args) {
-      r << arg;
-      if (&arg < &m_args.back())
-        r << ", ";
-    }
+  BinOp::BinOp(char op, ExprPtr lhs, ExprPtr rhs)
+    : m_op(op), m_lhs(std::move(lhs)), m_rhs(std::move(rhs)) {}
 
-    r << ")";
-
-    return r.str();
-  }
-
-  Module::Module(std::vector<TopLvlPtr> stmnts) : m_statements(stmnts) {}
+  Module::Module(std::vector<TopLvlPtr> stmnts, std::vector<Span> spans,
+                 uint32_t file, Arenas arenas)
+    : m_statements(std::move(stmnts)), m_spans(std::move(spans)),
+      m_file(file), m_arenas(std::move(arenas)) {}
 
   std::string Module::to_string() const {
     std::stringstream r;
-
-    for (auto &statement : m_statements) {
-      r << statement->to_string() << ";\n";
-    }
-
+    print(r);
     return r.str();
   }
 
+  void Module::print(std::ostream &os) const {
+    SourcePrinter(os).print(*this);
+  }
+
   // const auto Ident::parser  = Ident::PTrait::parser;
   // const auto Type::parser   = Type::PTrait::parser;
   // const auto Expr::parser   = Expr::PTrait::parser;
@@ -3,12 +3,20 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <memory>
 #include <type_traits>
 #include <variant>
+#include <functional>
+#include <unordered_map>
 
 #include <parser/location.h>
 #include <parser/parser.h>
+#include <parser/lexer.h>
+#include <parser/small_vector.h>
+#include <parser/arena.h>
+#include <parser/symbols.h>
 
 #include "context.h"
 
@@ -18,9 +26,10 @@
 namespace Fyre {
 
   // I know this isnt pretty, but cpp is too verbose
+  // Nodes live in the Arena of their Module, which frees them all at once
 #define decl_ptr(Typ) \
   class Typ;                                 \
-  using Typ##Ptr = std::shared_ptr<Typ>;
+  using Typ##Ptr = Typ *;
 
   decl_ptr(ANode);
   decl_ptr(TopLvl);
@@ -32,10 +41,17 @@ namespace Fyre {
   decl_ptr(FunDec);
   decl_ptr(FunDef);
   decl_ptr(FunCal);
-  decl_ptr(Module);
+  decl_ptr(BinOp);
 
 #undef decl_ptr
 
+  class Module;
+  using ModulePtr = std::shared_ptr<Module>;
+
+  class FlatModule;
+  class Printer;
+  class ExprTable;
+
   // template<class T>
   // struct ParsableAST {
   //   static ANodeP parse(Parser::Parser::IParseStream &);
@@ -58,12 +74,16 @@ namespace Fyre {
   //   Parser(T::parse);
 
 
+  /// A node of the AST
+
+  /// Nodes are never destroyed, their Arena goes all at once, so they
+  /// can only hold things that don't need to be: plain pointers to other
+  /// nodes, Slices, and interned names.
   class ANode {
   public:
-    virtual ~ANode() {};
-
-
     virtual std::string to_string() const = 0;
+    /// Write what to_string() gives to `os`
+    virtual void print(std::ostream &os) const { os << to_string(); }
 
   protected:
     Parser::Location *m_loc;
@@ -74,80 +94,198 @@ namespace Fyre {
   public:
     using StatementIR = std::variant<llvm::Function *>;
 
-    static TopLvlPtr parse(Parser::IParseStream &);
+    static Parser::Result<TopLvlPtr> parse(Parser::TokenCursor &);
+
+    std::string to_string() const override;
+    void print(std::ostream &os) const override;
 
     virtual StatementIR codegen(Context &ctx) const = 0;
+    /// Append this statement to `flat`
+    virtual void flatten(FlatModule &flat) const = 0;
+    /// Have `printer` write this statement
+    virtual void accept(Printer &printer) const = 0;
   };
 
   class Ident : public ANode {
   public:
-    Ident(std::string ident);
+    Ident(Parser::Symbol ident);
 
     std::string to_string() const;
 
-    static IdentPtr parse(Parser::IParseStream &);
+    static Parser::Result<IdentPtr> parse(Parser::TokenCursor &);
 
     std::string str() const;
+    Parser::Symbol symbol() const { return m_symbol; }
     // using PTrait = Parser::ParsableTrait<ParsableAST<Ident>>;
     // static const Parser::Parser<ANodeP> parser;
 
   protected:
-    std::string m_str;
+    Parser::Symbol m_symbol;
   };
 
   class Type : public ANode {
   public:
-    Type(std::string type, std::vector<TypePtr> args = {});
+    using Args = Parser::Slice<TypePtr>;
+
+    Type(Parser::Symbol type, Args args = {});
 
     std::string to_string() const;
+    void print(std::ostream &os) const override;
+
+    static Parser::Result<TypePtr> parse(Parser::TokenCursor &);
 
-    static TypePtr parse(Parser::IParseStream &);
+    Parser::Symbol symbol() const { return m_symbol; }
+    const Args &args() const { return m_args; }
 
     llvm::Type *codegen(Context &ctx) const;
+    /// Append this type to `flat`, giving its index
+    uint32_t flatten(FlatModule &flat) const;
     // using PTrait = Parser::ParsableTrait<ParsableAST<Type>>;
     // static const Parser::Parser<ANodeP> parser;
 
   protected:
-    std::string m_str;
-    std::vector<TypePtr> m_args;
+    Parser::Symbol m_symbol;
+    Args m_args;
   };
 
+  /// An expression, a tree of operands
+
+  /// Expressions can nest as deep as the input does, so nothing done to
+  /// a whole tree recurses on the C++ stack: printing and codegen walk
+  /// it with a stack of their own, each node only handling itself
+  /// through the virtuals below. After Module::share() an expression
+  /// can be a DAG, codegen and flatten then do a shared node once.
   class Expr : public ANode {
   public:
-    // std::string to_string() const;
+    std::string to_string() const override;
+    void print(std::ostream &os) const override;
 
-    static ExprPtr parse(Parser::IParseStream &);
+    static Parser::Result<ExprPtr> parse(Parser::TokenCursor &);
 
-    virtual llvm::Value *codegen(Context &ctx) const = 0;
-    // using PTrait = Parser::ParsableTrait<ParsableAST<Expr>>;
-    // static const Parser::Parser<ANodeP> parser;
+    /// Generate the whole expression, operands first
+    llvm::Value *codegen(Context &ctx) const;
+    /// Append the whole expression to `flat`, operands first, giving the
+    /// index of its root
+    uint32_t flatten(FlatModule &flat) const;
+    /// A copy of this expression made of the nodes of `table`, an equal
+    /// subexpression is the same node, this one is left as it is
+    ExprPtr share(ExprTable &table) const;
+
+    /// Whether this node of an ExprTable stands for several
+    bool shared() const { return m_shared; }
+
+    /// How many operands this is made of
+    virtual size_t operands() const { return 0; }
+    /// The i-th operand, in the order they are evaluated
+    virtual const Expr &operand(size_t i) const;
+
+    /// Have `printer` write what comes before operand i, or after the
+    /// last one if i is operands()
+    virtual void accept(Printer &printer, size_t i) const = 0;
+
+  protected:
+    /// Generate only this node, `values` are those of its operands
+    virtual llvm::Value *codegen_node(Context &ctx,
+                                      llvm::Value *const *values) const = 0;
+    /// Append only this node, `nodes` are the indices of its operands
+    virtual uint32_t flatten_node(FlatModule &flat,
+                                  const uint32_t *nodes) const = 0;
+    /// Intern only this node, `operands` are its interned operands
+    virtual ExprPtr share_node(ExprTable &table,
+                               const ExprPtr *operands) const = 0;
+
+    /// What `node(e, results)` gives for this expression, called on
+    /// every node after its operands, with what it gave for those. It
+    /// is called once for a shared node with operands, however many use
+    /// it.
+    template<class R, class F>
+    R post_order(F node) const {
+      struct Visit {
+        const Expr *expr;
+        size_t next;
+      };
+      Parser::SmallVector<Visit, 16> todo;
+      // the results of operands whose node isn't done yet
+      Parser::SmallVector<R, 16> results;
+      // and those of the shared nodes done, but leaves, which are
+      // cheaper to do again than to look up
+      std::unordered_map<const Expr *, R> done;
+      auto memo = [](const Expr *e) { return e->shared() && e->operands(); };
+      todo.push_back({ this, 0 });
+
+      while (!todo.empty()) {
+        const Expr *e = todo.back().expr;
+        size_t n = e->operands();
+
+        if (todo.back().next < n) {
+          const Expr *op = &e->operand(todo.back().next++);
+
+          auto it = memo(op) ? done.find(op) : done.end();
+          if (it != done.end())
+            results.push_back(it->second);
+          else
+            todo.push_back({ op, 0 });
+          continue;
+        }
+
+        R r = node(*e, results.end() - n);
+        for (size_t i = 0; i < n; i++)
+          results.pop_back();
+
+        if (memo(e))
+          done.emplace(e, r);
+
+        results.push_back(r);
+        todo.pop_back();
+      }
+
+      return results.back();
+    }
+
+    bool m_shared = false;
+
+    friend ExprTable;
   };
 
   class IntLit : public Expr {
   public:
     IntLit(long long int val = 0);
-    std::string to_string() const;
 
-    static IntLitPtr parse(Parser::IParseStream &);
-
-    llvm::Value *codegen(Context &ctx) const;
+    static Parser::Result<IntLitPtr> parse(Parser::TokenCursor &);
     // using PTrait = Parser::ParsableTrait<ParsableAST<Expr>>;
     // static const Parser::Parser<ANodeP> parser;
 
+    long long int value() const { return m_val; }
+
+    void accept(Printer &printer, size_t i) const override;
+
   protected:
+    llvm::Value *codegen_node(Context &ctx,
+                              llvm::Value *const *values) const override;
+    uint32_t flatten_node(FlatModule &flat,
+                          const uint32_t *nodes) const override;
+    ExprPtr share_node(ExprTable &table,
+                       const ExprPtr *operands) const override;
+
     long long int m_val;
   };
 
   class Var : public Expr {
   public:
     Var(IdentPtr name);
-    std::string to_string() const;
 
-    static VarPtr parse(Parser::IParseStream &);
+    IdentPtr name() const { return m_name; }
 
-    llvm::Value *codegen(Context &ctx) const;
+    void accept(Printer &printer, size_t i) const override;
 
   protected:
+    llvm::Value *codegen_node(Context &ctx,
+                              llvm::Value *const *values) const override;
+    uint32_t flatten_node(FlatModule &flat,
+                          const uint32_t *nodes) const override;
+    ExprPtr share_node(ExprTable &table,
+                       const ExprPtr *operands) const override;
+
     IdentPtr m_name;
   };
 
@@ -157,27 +295,33 @@ namespace Fyre {
       std::optional<IdentPtr> name;
       TypePtr type;
     };
+    using Args = Parser::Slice<Arg>;
 
     // TODO: implement contexts
-    FunDec(IdentPtr name, std::vector<Arg> args,
+    FunDec(IdentPtr name, Args args,
            TypePtr  type, std::optional<TypePtr> context = std::nullopt);
 
-    std::string to_string() const;
     std::string name_str() const;
 
-    static FunDecPtr parse(Parser::IParseStream &);
+    static Parser::Result<FunDecPtr> parse(Parser::TokenCursor &);
+
+    IdentPtr name() const { return m_name; }
+    const Args &args() const { return m_args; }
+    TypePtr type() const { return m_type; }
+    std::optional<TypePtr> context() const { return m_context; }
 
     TopLvl::StatementIR codegen(Context &ctx) const;
+    void flatten(FlatModule &flat) const override;
+    void accept(Printer &printer) const override;
     // using PTrait = Parser::ParsableTrait<ParsableAST<FunDec>>;
     // static const Parser::Parser<ANodeP> parser;
 
   protected:
     IdentPtr m_name;
-    std::vector<Arg> m_args;
+    Args m_args;
     TypePtr m_type;
     std::optional<TypePtr> m_context;
   };
-  std::ostream &operator<<(std::ostream &os, FunDec::Arg const &arg);
 
   class FunDef : public TopLvl {
   public:
@@ -185,74 +329,199 @@ namespace Fyre {
       IdentPtr name;
       std::optional<TypePtr> type;
     };
+    using Args = Parser::Slice<Arg>;
 
     // FunDef(ANodeP name, std::vector<Arg> args,
     //        ANodeP type,
     //        ANodeP expr);
-    FunDef(IdentPtr name, std::vector<Arg> args,
+    FunDef(IdentPtr name, Args args,
            TypePtr  type, std::optional<TypePtr> context,
            ExprPtr  expr);
 
-    std::string to_string() const;
     std::string name_str() const;
 
-    static FunDefPtr parse(Parser::IParseStream &);
+    static Parser::Result<FunDefPtr> parse(Parser::TokenCursor &);
+
+    IdentPtr name() const { return m_name; }
+    const Args &args() const { return m_args; }
+    TypePtr type() const { return m_type; }
+    std::optional<TypePtr> context() const { return m_context; }
+    ExprPtr expr() const { return m_expr; }
 
     TopLvl::StatementIR codegen(Context &ctx) const;
+    void flatten(FlatModule &flat) const override;
+    void accept(Printer &printer) const override;
     // using PTrait = Parser::ParsableTrait<ParsableAST<FunDec>>;
     // static const Parser::Parser<ANodeP> parser;
 
   protected:
     IdentPtr m_name;
-    std::vector<Arg> m_args;
+    Args m_args;
     TypePtr m_type;
     std::optional<TypePtr> m_context;
     ExprPtr m_expr;
   };
-  std::ostream &operator<<(std::ostream &os, FunDec::Arg const &arg);
 
   class FunCal : public Expr {
   public:
     using Arg = ExprPtr;
+    using Args = Parser::Slice<Arg>;
 
-    FunCal(IdentPtr name, std::vector<Arg> args);
-
-    std::string to_string() const;
-
-    static FunCalPtr parse(Parser::IParseStream &);
+    FunCal(IdentPtr name, Args args);
 
-    llvm::Value *codegen(Context &ctx) const;
+    size_t operands() const override { return m_args.size(); }
+    const Expr &operand(size_t i) const override { return *m_args[i]; }
     // using PTrait = Parser::ParsableTrait<ParsableAST<FunDec>>;
     // static const Parser::Parser<ANodeP> parser;
 
+    IdentPtr name() const { return m_name; }
+
+    void accept(Printer &printer, size_t i) const override;
+
   protected:
+    llvm::Value *codegen_node(Context &ctx,
+                              llvm::Value *const *values) const override;
+    uint32_t flatten_node(FlatModule &flat,
+                          const uint32_t *nodes) const override;
+    ExprPtr share_node(ExprTable &table,
+                       const ExprPtr *operands) const override;
+
     IdentPtr m_name;
-    std::vector<Arg> m_args;
+    Args m_args;
+  };
+
+  /// An arithmetic operator applied to two operands, made by Expr::parse
+  class BinOp : public Expr {
+  public:
+    BinOp(char op, ExprPtr lhs, ExprPtr rhs);
+
+    size_t operands() const override { return 2; }
+    const Expr &operand(size_t i) const override {
+      return i == 0 ? *m_lhs : *m_rhs;
+    }
+
+    char op() const { return m_op; }
+
+    void accept(Printer &printer, size_t i) const override;
+
+  protected:
+    llvm::Value *codegen_node(Context &ctx,
+                              llvm::Value *const *values) const override;
+    uint32_t flatten_node(FlatModule &flat,
+                          const uint32_t *nodes) const override;
+    ExprPtr share_node(ExprTable &table,
+                       const ExprPtr *operands) const override;
+
+    char m_op;
+    ExprPtr m_lhs;
+    ExprPtr m_rhs;
   };
 
 
+  /// Statements, and the arenas their nodes are in
+
+  /// A module that shares statements with another, as reparse() makes,
+  /// shares those arenas too.
   class Module : public ANode {
   public:
-    Module(std::vector<TopLvlPtr>);
+    using Arenas = std::vector<std::shared_ptr<Parser::Arena>>;
+
+    /// Where a statement is in the source, from its first token to the
+    /// end of its last
+    struct Span {
+      uint32_t offset;
+      uint32_t length;
+      // where the last token parsing it looked at ends, which may be
+      // past its end, an edit before that can change it
+      uint32_t reach;
+
+      uint32_t end() const { return offset + length; }
+    };
+
+    /// `removed` bytes at `offset` replaced with `inserted`
+    struct Edit {
+      uint32_t offset;
+      uint32_t removed;
+      std::string_view inserted;
+    };
+
+    Module(std::vector<TopLvlPtr> stmnts, std::vector<Span> spans,
+           uint32_t file, Arenas arenas);
 
     std::string to_string() const;
+    void print(std::ostream &os) const override;
+
+    const std::vector<TopLvlPtr> &statements() const { return m_statements; }
+    const std::vector<Span> &spans() const { return m_spans; }
+
+    static Parser::Result<ModulePtr> parse(Parser::TokenCursor &);
+
+    /// Parse statements from `in`, handing each to `sink` as soon as it
+    /// is parsed, as a Module of its own. Nothing is kept, the number of
+    /// statements is returned.
+    static Parser::Result<size_t>
+    stream(Parser::TokenCursor &in,
+           const std::function<void(ModulePtr)> &sink);
+
+    /// Parse `src`, which is this module's source with `edit` applied
+
+    /// Only the statements the edit touches are parsed again, up to the
+    /// first old statement the parse lines up with. All other
+    /// statements are shared with this module, their spans shifted.
+    /// Throws a Parser::Error if the new source doesn't parse.
+    ModulePtr reparse(std::string_view src, const Edit &edit) const;
 
-    static ModulePtr parse(Parser::IParseStream &);
+    /// Parse the rest of `in` on up to `jobs` threads
+
+    /// The input is cut at top-level `;`s, and at newlines followed by
+    /// a statement's name, arguments and type, and the pieces are parsed
+    /// separately, then put back together in order. The Budget of `in`
+    /// is for all the pieces together, their stats are added to it.
+    static ModulePtr parse_parallel(Parser::ParseCursor &in, unsigned jobs);
+    /// Where parse_parallel() cuts `src` into about `pieces` pieces of
+    /// whole statements: the offset of each, then the end of `src`
+    static std::vector<size_t> split(std::string_view src, size_t pieces);
 
     // std::unique_ptr<llvm::Module> codegen() const;
     std::unique_ptr<ContextRoot> codegen(const std::string &) const;
 
+    /// Generate one statement into `ctx`, as codegen() does for each
+    static void codegen_statement(Context &ctx, const TopLvl &stmnt);
+
+    /// This module with equal subexpressions made one node
+
+    /// Expressions are pure, so a node can stand for all that are equal
+    /// to it: the same kind of node with the same operands. Definitions
+    /// are copied, with their expressions, into an arena of the new
+    /// module's own, everything else is shared with this module, which
+    /// is left as it is.
+    ModulePtr share() const;
+
   protected:
     std::vector<TopLvlPtr> m_statements;
+    std::vector<Span> m_spans;
+    // the input the spans are in
+    uint32_t m_file;
+    Arenas m_arenas;
   };
 
 
   std::ostream &operator<<(std::ostream &os, ANode const &id);
 
-  template<class T>
-  std::ostream &operator<<(std::ostream &os, std::shared_ptr<T> const &id) {
-    return os << *static_cast<ANodePtr>(id);
+  template<class T,
+           class = std::enable_if_t<std::is_base_of_v<ANode, T>>>
+  std::ostream &operator<<(std::ostream &os, T *const &id) {
+    return os << *static_cast<const ANode *>(id);
+  }
+
+  inline std::ostream &operator<<(std::ostream &os, ModulePtr const &id) {
+    return os << *id;
   }
 }
 
+// alternatives keep re-parsing these at the same spot
+template<> struct Parser::Memoize<Fyre::Ident> : std::true_type {};
+template<> struct Parser::Memoize<Fyre::Type>  : std::true_type {};
+template<> struct Parser::Memoize<Fyre::Expr>  : std::true_type {};
+
 #endif
@@ -0,0 +1,94 @@
+#include "cache.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Fyre {
+  namespace Cache {
+    namespace {
+      uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+      }
+
+      // the toolchain lays out the arrays cached as they are in memory
+      constexpr uint64_t toolchain(const char *s) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (; *s; s++)
+          h = (h ^ (unsigned char)*s) * 0x100000001b3ULL;
+        return h;
+      }
+      constexpr uint64_t build = toolchain(__VERSION__) ^ compiler;
+    }
+
+    uint64_t key(std::string_view text, uint64_t variant) {
+      // a word at a time, a source is hashed on every run
+      uint64_t h = mix(mix(variant) ^ mix(build) ^ text.size() ^
+                       0x9e3779b97f4a7c15ULL);
+
+      size_t i = 0;
+      for (; i + 8 <= text.size(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, text.data() + i, 8);
+        h = (h ^ mix(w)) * 0x100000001b3ULL;
+      }
+
+      uint64_t tail = 0;
+      if (i < text.size())
+        std::memcpy(&tail, text.data() + i, text.size() - i);
+      return mix(h ^ mix(tail));
+    }
+
+    std::string path(const std::string &file) {
+      return file + ".fyc";
+    }
+
+    std::unique_ptr<FlatModule> load(const std::string &path, uint64_t key) {
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        return nullptr;
+
+      struct stat st;
+      void *map = MAP_FAILED;
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+
+      if (map == MAP_FAILED)
+        return nullptr;
+
+      auto module = FlatModule::read((const char *)map, st.st_size, key);
+      munmap(map, st.st_size);
+      return module;
+    }
+
+    void store(const std::string &path, uint64_t key,
+               const FlatModule &module) {
+      // written aside and renamed over, so a reader never sees half of it
+      std::string tmp = path + "." + std::to_string(getpid());
+      {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        module.write(out, key);
+        out.flush();
+
+        if (!out) {
+          std::remove(tmp.c_str());
+          return;
+        }
+      }
+
+      if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        std::remove(tmp.c_str());
+    }
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef FYRE_CACHE_H
+#define FYRE_CACHE_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+
+#include "flat.h"
+
+namespace Fyre {
+  /// Flat modules kept next to their sources, so unchanged sources
+  /// aren't parsed again
+
+  /// A cached module is keyed by a hash of the source text it was made
+  /// from and of the compiler that made it, so a stale cache is just a
+  /// miss and gets replaced.
+  namespace Cache {
+    /// The revision of what parsing and flattening make of a source
+
+    /// Bump it with any change to the modules they build: a cache made
+    /// before is then a miss rather than the old compiler's output. A
+    /// change to the binary form bumps the version in flat.cpp instead,
+    /// the toolchain that built fyrec goes in the key by itself.
+    constexpr uint64_t compiler = 1;
+
+    /// The key of a source text for this compiler, `variant` tells apart
+    /// modules made differently from the same text
+    uint64_t key(std::string_view text, uint64_t variant = 0);
+
+    /// Where the cache of the source file `file` goes
+    std::string path(const std::string &file);
+
+    /// The module cached at `path` for `key`, read from the mmapped
+    /// file, null if there is none
+    std::unique_ptr<FlatModule> load(const std::string &path, uint64_t key);
+
+    /// Replace what's at `path`, failing to is no error: there's just
+    /// no cache next time
+    void store(const std::string &path, uint64_t key,
+               const FlatModule &module);
+  }
+}
+
+#endif
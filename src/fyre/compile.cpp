@@ -2,6 +2,9 @@
 #include "context.h"
 #include "AST.h"
 #include "exceptions.h"
+#include "flat.h"
+
+#include <parser/symbols.h>
 
 #include <llvm/ADT/APInt.h>
 #include <llvm/IR/LLVMContext.h>
@@ -11,20 +14,48 @@
 #include <stdexcept>
 #include <memory>
 #include <variant>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <optional>
+#include <exception>
 
 namespace Fyre {
   // CompiledVal::CompiledVal(ValueT v) : m_value(v) {}
 
 
-  llvm::Value *IntLit::codegen(Context &ctx) const {
+  llvm::Value *Expr::codegen(Context &ctx) const {
+    return post_order<llvm::Value *>([&](const Expr &e,
+                                         llvm::Value *const *values) {
+      return e.codegen_node(ctx, values);
+    });
+  }
+
+  llvm::Value *IntLit::codegen_node(Context &ctx, llvm::Value *const *) const {
     return llvm::ConstantInt::get(ctx.llvm_ctx(), llvm::APInt(64, m_val, true));
   }
 
+  namespace {
+    // the text of an interned name, for LLVM, without a copy
+    llvm::StringRef text(Parser::Symbol name) {
+      std::string_view v = Parser::Symbols::str(name);
+      return llvm::StringRef(v.data(), v.size());
+    }
+
+    llvm::Type *builtin_type(Context &ctx, Parser::Symbol name) {
+      static const Parser::Symbol Int = Parser::Symbols::intern("Int");
+
+      if (name == Int)
+        return llvm::Type::getInt64Ty(ctx.llvm_ctx());
+      else
+        throw std::out_of_range("Type not found for id: " +
+                                text(name).str());
+    }
+  }
+
   llvm::Type *Type::codegen(Context &ctx) const {
-    if (m_str == "Int")
-      return llvm::Type::getInt64Ty(ctx.llvm_ctx());
-    else
-      throw std::out_of_range("Type not found for id: " + m_str);
+    return builtin_type(ctx, m_symbol);
   }
 
   TopLvl::StatementIR FunDec::codegen(Context &ctx) const {
@@ -39,13 +70,13 @@ namespace Fyre {
     llvm::Function *fn =
       llvm::Function::Create(ft,
                              llvm::Function::ExternalLinkage,
-                             m_name->str(),
+                             text(m_name->symbol()),
                              &ctx.module());
 
     int i = 0;
     for (auto &arg : fn->args()) {
       if (m_args[i].name)
-        arg.setName((*m_args[i].name)->str());
+        arg.setName(text((*m_args[i].name)->symbol()));
       i++;
     }
 
@@ -55,8 +86,8 @@ namespace Fyre {
   TopLvl::StatementIR FunDef::codegen(Context &ctx) const {
     llvm::Function *fn;
 
-    if (ctx.has_function(m_name->str())) {
-      fn = ctx.function(m_name->str());
+    if (ctx.has_function(m_name->symbol())) {
+      fn = ctx.function(m_name->symbol());
     } else {
       std::vector<llvm::Type *> arg_types;
 
@@ -72,15 +103,15 @@ namespace Fyre {
 
       fn = llvm::Function::Create(ft,
                                   llvm::Function::ExternalLinkage,
-                                  m_name->str(),
+                                  text(m_name->symbol()),
                                   &ctx.module());
     }
 
     ContextChild scope = ctx.make_frame();
     int i = 0;
     for (auto &arg : fn->args()) {
-      scope.value(m_args[i].name->str(), &arg);
-      arg.setName(m_args[i++].name->str());
+      scope.value(m_args[i].name->symbol(), &arg);
+      arg.setName(text(m_args[i++].name->symbol()));
     }
 
     llvm::BasicBlock *entry = llvm::BasicBlock::Create(ctx.llvm_ctx(), "entry", fn);
@@ -94,36 +125,279 @@ namespace Fyre {
     return fn;
   }
 
-  llvm::Value *FunCal::codegen(Context &ctx) const {
-    llvm::Function *fn = ctx.function(m_name->str());
+  llvm::Value *FunCal::codegen_node(Context &ctx,
+                                    llvm::Value *const *values) const {
+    llvm::Function *fn = ctx.function(m_name->symbol());
 
-    std::vector<llvm::Value *> args;
-    for (auto &arg : m_args)
-      args.push_back(arg->codegen(ctx));
+    llvm::ArrayRef<llvm::Value *> args(values, m_args.size());
 
     return ctx.builder().CreateCall(fn, args, "calltmp");
   }
 
-  llvm::Value *Var::codegen(Context &ctx) const {
-    return ctx.value(m_name->str());
+  llvm::Value *Var::codegen_node(Context &ctx, llvm::Value *const *) const {
+    return ctx.value(m_name->symbol());
+  }
+
+  llvm::Value *BinOp::codegen_node(Context &ctx,
+                                   llvm::Value *const *values) const {
+    llvm::Value *lhs = values[0];
+    llvm::Value *rhs = values[1];
+
+    switch (m_op) {
+    case '+': return ctx.builder().CreateAdd(lhs, rhs, "addtmp");
+    case '-': return ctx.builder().CreateSub(lhs, rhs, "subtmp");
+    case '*': return ctx.builder().CreateMul(lhs, rhs, "multmp");
+    case '/': return ctx.builder().CreateSDiv(lhs, rhs, "divtmp");
+    case '%': return ctx.builder().CreateSRem(lhs, rhs, "remtmp");
+    default:
+      throw Compiler::Error(std::string("Unknown operator ") + m_op);
+    }
+  }
+
+  void Module::codegen_statement(Context &ctx, const TopLvl &stmnt) {
+    auto ir = stmnt.codegen(ctx);
+
+    // Handle Function*
+    using F = llvm::Function *;
+    if (std::holds_alternative<F>(ir)) {
+      F fn = std::get<F>(ir);
+
+      llvm::StringRef name = fn->getName();
+      ctx.function(Parser::Symbols::intern({ name.data(), name.size() }), fn);
+    }
   }
 
   std::unique_ptr<ContextRoot> Module::codegen(const std::string &module_name) const {
     auto ctx = std::make_unique<ContextRoot>(module_name);
 
-    for (auto toplvl : m_statements) {
-      auto ir =  toplvl->codegen(*ctx);
+    for (auto &toplvl : m_statements)
+      codegen_statement(*ctx, *toplvl);
+
+    // return module;
+    return ctx;
+  }
+
+  llvm::Type *FlatModule::codegen_type(Context &ctx, Index type) const {
+    return builtin_type(ctx, m_types[type].name);
+  }
+
+  llvm::Function *
+  FlatModule::codegen_function(Context &ctx, const Function &fn,
+                               std::vector<llvm::Value *> &values) const {
+    const Param *params = m_params.data() + fn.params;
+    llvm::Function *f;
+
+    // like FunDef::codegen(), a definition completes its declaration
+    if (fn.body != none && ctx.has_function(fn.name)) {
+      f = ctx.function(fn.name);
+    } else {
+      std::vector<llvm::Type *> arg_types;
+
+      for (Index i = 0; i < fn.arity; i++) {
+        if (params[i].type == none)
+          throw Compiler::Error("Missing type for argument " +
+                                text(params[i].name).str());
+
+        arg_types.push_back(codegen_type(ctx, params[i].type));
+      }
 
-      // Handle Function*
-      using F = llvm::Function *;
-      if (std::holds_alternative<F>(ir)) {
-        F fn = std::get<F>(ir);
+      llvm::FunctionType *ft =
+        llvm::FunctionType::get(codegen_type(ctx, fn.type), arg_types, false);
 
-        ctx->function(fn->getName(), fn);
+      f = llvm::Function::Create(ft,
+                                 llvm::Function::ExternalLinkage,
+                                 text(fn.name),
+                                 &ctx.module());
+    }
+
+    ContextChild scope = ctx.make_frame();
+    Index i = 0;
+    for (auto &arg : f->args()) {
+      if (params[i].name != none) {
+        if (fn.body != none)
+          scope.value(params[i].name, &arg);
+        arg.setName(text(params[i].name));
       }
+      i++;
+    }
+
+    if (fn.body == none)
+      return f;
+
+    llvm::BasicBlock *entry = llvm::BasicBlock::Create(ctx.llvm_ctx(), "entry", f);
+    llvm::IRBuilder<> &builder = ctx.builder();
+    builder.SetInsertPoint(entry);
+
+    // operands come before the nodes using them, one pass does it all
+    values.resize(fn.body + 1 - fn.begin);
+    auto value = [&](Index node) { return values[node - fn.begin]; };
+
+    for (Index node = fn.begin; node <= fn.body; node++) {
+      Index lhs = m_lhs[node], rhs = m_rhs[node];
+      llvm::Value *&v = values[node - fn.begin];
+
+      switch (m_kinds[node]) {
+      case IntLit:
+        v = llvm::ConstantInt::get(ctx.llvm_ctx(),
+                                   llvm::APInt(64, m_ints[lhs], true));
+        break;
+
+      case Var:
+        v = scope.value(lhs);
+        break;
+
+      case Call: {
+        llvm::Function *callee = scope.function(lhs);
+
+        Index n = m_call_args[rhs];
+        Parser::SmallVector<llvm::Value *, 4> args;
+        for (Index k = 0; k < n; k++)
+          args.push_back(value(m_call_args[rhs + 1 + k]));
+
+        v = builder.CreateCall(callee,
+                               llvm::ArrayRef<llvm::Value *>(args.data(), n),
+                               "calltmp");
+        break;
+      }
+
+      case Add: v = builder.CreateAdd (value(lhs), value(rhs), "addtmp"); break;
+      case Sub: v = builder.CreateSub (value(lhs), value(rhs), "subtmp"); break;
+      case Mul: v = builder.CreateMul (value(lhs), value(rhs), "multmp"); break;
+      case Div: v = builder.CreateSDiv(value(lhs), value(rhs), "divtmp"); break;
+      case Rem: v = builder.CreateSRem(value(lhs), value(rhs), "remtmp"); break;
+      }
+    }
+
+    builder.CreateRet(value(fn.body));
+
+    // TODO: use the return val of this
+    llvm::verifyFunction(*f);
+
+    return f;
+  }
+
+  std::unique_ptr<ContextRoot>
+  FlatModule::codegen(const std::string &module_name) const {
+    auto ctx = std::make_unique<ContextRoot>(module_name);
+    std::vector<llvm::Value *> values;
+
+    for (auto &fn : m_functions) {
+      llvm::Function *f = codegen_function(*ctx, fn, values);
+      ctx->function(fn.name, f);
     }
 
-    // return module;
     return ctx;
   }
+
+  namespace {
+    // hands values from one thread to another, holding at most `size`
+    template<class T>
+    class BoundedQueue {
+    public:
+      BoundedQueue(size_t size) : m_size(size), m_closed(false) {}
+
+      // false if the queue was closed, the value is dropped then
+      bool push(T v) {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_not_full.wait(guard, [&] {
+          return m_queue.size() < m_size || m_closed;
+        });
+
+        if (m_closed)
+          return false;
+
+        m_queue.push_back(std::move(v));
+        m_not_empty.notify_one();
+        return true;
+      }
+
+      // nullopt once the queue is closed and empty
+      std::optional<T> pop() {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_not_empty.wait(guard, [&] { return !m_queue.empty() || m_closed; });
+
+        if (m_queue.empty())
+          return std::nullopt;
+
+        T v = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_not_full.notify_one();
+        return v;
+      }
+
+      void close() {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_closed = true;
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+      }
+
+    private:
+      std::deque<T> m_queue;
+      size_t m_size;
+      bool m_closed;
+
+      std::mutex m_lock;
+      std::condition_variable m_not_full;
+      std::condition_variable m_not_empty;
+    };
+
+    // unwinds the parser thread once nobody takes statements anymore
+    struct Cancelled {};
+  }
+
+  void compile_stream(Parser::TokenCursor &in, Context &ctx,
+                      const std::function<void(const TopLvl &)> &each,
+                      size_t queue) {
+    // each Module streamed has one statement, and frees it when it goes
+    auto compile = [&](const Module &module) {
+      for (auto stmnt : module.statements()) {
+        each(*stmnt);
+        Module::codegen_statement(ctx, *stmnt);
+      }
+    };
+
+    if (queue == 0) {
+      auto r = Module::stream(in, [&](ModulePtr module) {
+        compile(*module);
+      });
+      if (!r)
+        throw in.error();
+      return;
+    }
+
+    BoundedQueue<ModulePtr> stmnts(queue);
+    std::exception_ptr error;
+
+    std::thread parser([&]() {
+      try {
+        auto r = Module::stream(in, [&](ModulePtr module) {
+          if (!stmnts.push(std::move(module)))
+            throw Cancelled();
+        });
+        if (!r)
+          error = std::make_exception_ptr(in.error());
+
+      } catch (Cancelled &) {
+      } catch (...) {
+        error = std::current_exception();
+      }
+      stmnts.close();
+    });
+
+    try {
+      // everything parsed before an error still gets compiled, like
+      // without the queue
+      while (auto module = stmnts.pop())
+        compile(**module);
+    } catch (...) {
+      stmnts.close();
+      parser.join();
+      throw;
+    }
+
+    parser.join();
+    if (error)
+      std::rethrow_exception(error);
+  }
 }
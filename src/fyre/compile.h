@@ -13,7 +13,27 @@
 // #include "AST.h"
 // #include "context.h"
 
+#include <functional>
+#include <cstddef>
+
+#include "parser/lexer.h"
+
+#include "AST.h"
+#include "context.h"
+
 namespace Fyre {
+  /// Parse `in` and generate each statement into `ctx` as it comes
+
+  /// A statement's AST is freed as soon as its IR exists, so the whole
+  /// module is never held at once. `each` sees every statement just
+  /// before it is compiled. With a `queue` size, parsing runs on a
+  /// thread of its own, at most that many statements ahead of codegen.
+  /// Throws the Parser::Error of the first statement that doesn't parse,
+  /// after compiling everything before it.
+  void compile_stream(Parser::TokenCursor &in, Context &ctx,
+                      const std::function<void(const TopLvl &)> &each,
+                      size_t queue = 0);
+
   // using LLVMContextPtr = std::shared_ptr<llvm::LLVMContext>;
 
 
@@ -1,5 +1,7 @@
 #include "context.h"
 
+#include <stdexcept>
+
 namespace Fyre {
   ContextRoot::ContextRoot(std::string module_name) :
     m_builder(m_llvm_ctx),
@@ -16,51 +18,46 @@ namespace Fyre {
     return m_module;
   }
 
-  bool ContextRoot::has_value(const std::string &id) {
-    if (m_values.count(id))
-      return true;
-    else
-      return false;
+  namespace {
+    // the entry for `id`, or a not found error naming it
+    template<class Map>
+    typename Map::mapped_type lookup(Map &map, Parser::Symbol id,
+                                     const char *what) {
+      auto it = map.find(id);
+      if (it == map.end())
+        throw std::out_of_range(std::string(what) + " not found for id: " +
+                                std::string(Parser::Symbols::str(id)));
+      return it->second;
+    }
   }
-  bool ContextRoot::has_function(const std::string &id) {
-    if (m_functions.count(id))
-      return true;
-    else
-      return false;
+
+  bool ContextRoot::has_value(Parser::Symbol id) {
+    return m_values.count(id);
   }
-  bool ContextRoot::has_type(const std::string &id) {
-    if (m_types.count(id))
-      return true;
-    else
-      return false;
+  bool ContextRoot::has_function(Parser::Symbol id) {
+    return m_functions.count(id);
+  }
+  bool ContextRoot::has_type(Parser::Symbol id) {
+    return m_types.count(id);
   }
 
-  llvm::Value *ContextRoot::value(const std::string &id) {
-    if (has_value(id))
-      return m_values[id];
-    else
-      throw std::out_of_range("Value not found for id: " + id);
+  llvm::Value *ContextRoot::value(Parser::Symbol id) {
+    return lookup(m_values, id, "Value");
   }
-  llvm::Function *ContextRoot::function(const std::string &id) {
-    if (has_function(id))
-      return m_functions[id];
-    else
-      throw std::out_of_range("Function not found for id: " + id);
+  llvm::Function *ContextRoot::function(Parser::Symbol id) {
+    return lookup(m_functions, id, "Function");
   }
-  llvm::Type *ContextRoot::type(const std::string &id) {
-    if (has_type(id))
-      return m_types[id];
-    else
-      throw std::out_of_range("Type not found for id: " + id);
+  llvm::Type *ContextRoot::type(Parser::Symbol id) {
+    return lookup(m_types, id, "Type");
   }
 
-  void ContextRoot::value(const std::string &id, llvm::Value *v) {
+  void ContextRoot::value(Parser::Symbol id, llvm::Value *v) {
     m_values[id] = v;
   }
-  void ContextRoot::function(const std::string &id, llvm::Function *f) {
+  void ContextRoot::function(Parser::Symbol id, llvm::Function *f) {
     m_functions[id] = f;
   }
-  void ContextRoot::type(const std::string &id, llvm::Type *t) {
+  void ContextRoot::type(Parser::Symbol id, llvm::Type *t) {
     m_types[id] = t;
   }
 
@@ -82,51 +79,54 @@ namespace Fyre {
     return m_parent.module();
   }
 
-  bool ContextChild::has_value (const std::string &id) {
+  bool ContextChild::has_value (Parser::Symbol id) {
     if (m_values.count(id))
       return true;
     else
       return m_parent.has_value(id);
   }
-  bool ContextChild::has_function(const std::string &id) {
+  bool ContextChild::has_function(Parser::Symbol id) {
     if (m_functions.count(id))
       return true;
     else
       return m_parent.has_function(id);
   }
-  bool ContextChild::has_type(const std::string &id) {
+  bool ContextChild::has_type(Parser::Symbol id) {
     if (m_types.count(id))
       return true;
     else
       return m_parent.has_type(id);
   }
 
-  llvm::Value *ContextChild::value(const std::string &id) {
-    if (m_values.count(id))
-      return m_values[id];
+  llvm::Value *ContextChild::value(Parser::Symbol id) {
+    auto it = m_values.find(id);
+    if (it != m_values.end())
+      return it->second;
     else
       return m_parent.value(id);
   }
-  llvm::Function *ContextChild::function(const std::string &id) {
-    if (m_functions.count(id))
-      return m_functions[id];
+  llvm::Function *ContextChild::function(Parser::Symbol id) {
+    auto it = m_functions.find(id);
+    if (it != m_functions.end())
+      return it->second;
     else
       return m_parent.function(id);
   }
-  llvm::Type *ContextChild::type(const std::string &id) {
-    if (m_types.count(id))
-      return m_types[id];
+  llvm::Type *ContextChild::type(Parser::Symbol id) {
+    auto it = m_types.find(id);
+    if (it != m_types.end())
+      return it->second;
     else
       return m_parent.type(id);
   }
 
-  void ContextChild::value(const std::string &id, llvm::Value *v) {
+  void ContextChild::value(Parser::Symbol id, llvm::Value *v) {
     m_values[id] = v;
   }
-  void ContextChild::function(const std::string &id, llvm::Function *f) {
+  void ContextChild::function(Parser::Symbol id, llvm::Function *f) {
     m_functions[id] = f;
   }
-  void ContextChild::type(const std::string &id, llvm::Type *t) {
+  void ContextChild::type(Parser::Symbol id, llvm::Type *t) {
     m_types[id] = t;
   }
 
@@ -1,7 +1,8 @@
 #ifndef CONTEXT_H
 #define CONTEXT_H
 
-#include <map>
+#include <string>
+#include <unordered_map>
 #include <optional>
 
 #include <llvm/IR/IRBuilder.h>
@@ -10,6 +11,8 @@
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Type.h>
 
+#include <parser/symbols.h>
+
 namespace Fyre {
   class ContextChild;
 
@@ -17,7 +20,7 @@ namespace Fyre {
 
   /// This is passed down the codegen process and holds
   /// the llvm builder, context and module. It also
-  /// holds the scope and symbol table.
+  /// holds the scope and symbol table, keyed by interned names.
   class Context {
   public:
     virtual ~Context() {};
@@ -30,32 +33,32 @@ namespace Fyre {
     virtual llvm::Module      &module() = 0;
 
     /// Return whether value exists
-    virtual bool has_value   (const std::string &) = 0;
+    virtual bool has_value   (Parser::Symbol) = 0;
     /// Return whether function exists
-    virtual bool has_function(const std::string &) = 0;
+    virtual bool has_function(Parser::Symbol) = 0;
     /// Return whether type exists
-    virtual bool has_type    (const std::string &) = 0;
+    virtual bool has_type    (Parser::Symbol) = 0;
 
     /// Get value by id
-    virtual llvm::Value    *value   (const std::string &) = 0;
+    virtual llvm::Value    *value   (Parser::Symbol) = 0;
     /// Get function by id
-    virtual llvm::Function *function(const std::string &) = 0;
+    virtual llvm::Function *function(Parser::Symbol) = 0;
     /// Get type by id
-    virtual llvm::Type     *type    (const std::string &) = 0;
+    virtual llvm::Type     *type    (Parser::Symbol) = 0;
 
     /// Set value by id
-    virtual void value   (const std::string &, llvm::Value *) = 0;
+    virtual void value   (Parser::Symbol, llvm::Value *) = 0;
     /// Set function by id
-    virtual void function(const std::string &, llvm::Function *) = 0;
+    virtual void function(Parser::Symbol, llvm::Function *) = 0;
     /// Set type by id
-    virtual void type    (const std::string &, llvm::Type *) = 0;
+    virtual void type    (Parser::Symbol, llvm::Type *) = 0;
 
     virtual ContextChild make_frame() = 0;
 
   protected:
-    using ValueMap    = std::map<std::string, llvm::Value *>;
-    using FunctionMap = std::map<std::string, llvm::Function *>;
-    using TypeMap     = std::map<std::string, llvm::Type *>;
+    using ValueMap    = std::unordered_map<Parser::Symbol, llvm::Value *>;
+    using FunctionMap = std::unordered_map<Parser::Symbol, llvm::Function *>;
+    using TypeMap     = std::unordered_map<Parser::Symbol, llvm::Type *>;
   };
 
   /// A subcontext of some parent Context.
@@ -70,17 +73,17 @@ namespace Fyre {
     llvm::IRBuilder<> &builder() override;
     llvm::Module      &module() override;
 
-    bool has_value   (const std::string &) override;
-    bool has_function(const std::string &) override;
-    bool has_type    (const std::string &) override;
+    bool has_value   (Parser::Symbol) override;
+    bool has_function(Parser::Symbol) override;
+    bool has_type    (Parser::Symbol) override;
 
-    llvm::Value    *value   (const std::string &) override;
-    llvm::Function *function(const std::string &) override;
-    llvm::Type     *type    (const std::string &) override;
+    llvm::Value    *value   (Parser::Symbol) override;
+    llvm::Function *function(Parser::Symbol) override;
+    llvm::Type     *type    (Parser::Symbol) override;
 
-    void value   (const std::string &, llvm::Value *) override;
-    void function(const std::string &, llvm::Function *) override;
-    void type    (const std::string &, llvm::Type *) override;
+    void value   (Parser::Symbol, llvm::Value *) override;
+    void function(Parser::Symbol, llvm::Function *) override;
+    void type    (Parser::Symbol, llvm::Type *) override;
 
     ContextChild make_frame() override;
 
@@ -109,17 +112,17 @@ namespace Fyre {
     llvm::IRBuilder<> &builder() override;
     llvm::Module      &module() override;
 
-    bool has_value   (const std::string &) override;
-    bool has_function(const std::string &) override;
-    bool has_type    (const std::string &) override;
+    bool has_value   (Parser::Symbol) override;
+    bool has_function(Parser::Symbol) override;
+    bool has_type    (Parser::Symbol) override;
 
-    llvm::Value    *value   (const std::string &) override;
-    llvm::Function *function(const std::string &) override;
-    llvm::Type     *type    (const std::string &) override;
+    llvm::Value    *value   (Parser::Symbol) override;
+    llvm::Function *function(Parser::Symbol) override;
+    llvm::Type     *type    (Parser::Symbol) override;
 
-    void value   (const std::string &, llvm::Value *) override;
-    void function(const std::string &, llvm::Function *) override;
-    void type    (const std::string &, llvm::Type *) override;
+    void value   (Parser::Symbol, llvm::Value *) override;
+    void function(Parser::Symbol, llvm::Function *) override;
+    void type    (Parser::Symbol, llvm::Type *) override;
 
     ContextChild make_frame() override;
 
@@ -0,0 +1,565 @@
+#include <sstream>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+#include "flat.h"
+#include "exceptions.h"
+
+#include <parser/symbols.h>
+#include <parser/small_vector.h>
+
+namespace Symbols = Parser::Symbols;
+
+namespace Fyre {
+  using Index = FlatModule::Index;
+
+  // Laying the AST out
+
+  uint32_t Type::flatten(FlatModule &flat) const {
+    Parser::SmallVector<Index, 4> args;
+    for (auto &arg : m_args)
+      args.push_back(arg->flatten(flat));
+
+    return flat.add_type(m_symbol, args.data(), args.size());
+  }
+
+  uint32_t Expr::flatten(FlatModule &flat) const {
+    return post_order<Index>([&](const Expr &e, const Index *nodes) {
+      return e.flatten_node(flat, nodes);
+    });
+  }
+
+  uint32_t IntLit::flatten_node(FlatModule &flat, const uint32_t *) const {
+    return flat.add_int(m_val);
+  }
+
+  uint32_t Var::flatten_node(FlatModule &flat, const uint32_t *) const {
+    return flat.add_var(m_name->symbol());
+  }
+
+  uint32_t FunCal::flatten_node(FlatModule &flat,
+                                const uint32_t *nodes) const {
+    return flat.add_call(m_name->symbol(), nodes, m_args.size());
+  }
+
+  uint32_t BinOp::flatten_node(FlatModule &flat,
+                               const uint32_t *nodes) const {
+    return flat.add_binop(m_op, nodes[0], nodes[1]);
+  }
+
+  void FunDec::flatten(FlatModule &flat) const {
+    Parser::SmallVector<FlatModule::Param, 4> params;
+    for (auto &arg : m_args)
+      params.push_back({ arg.name ? (*arg.name)->symbol() : FlatModule::none,
+                         arg.type->flatten(flat) });
+
+    FlatModule::Function fn;
+    fn.name    = m_name->symbol();
+    fn.params  = flat.add_params(params.data(), params.size());
+    fn.arity   = params.size();
+    fn.type    = m_type->flatten(flat);
+    fn.context = m_context ? (*m_context)->flatten(flat) : FlatModule::none;
+    fn.begin   = FlatModule::none;
+    fn.body    = FlatModule::none;
+
+    flat.add_function(fn);
+  }
+
+  void FunDef::flatten(FlatModule &flat) const {
+    Parser::SmallVector<FlatModule::Param, 4> params;
+    for (auto &arg : m_args)
+      params.push_back({ arg.name->symbol(),
+                         arg.type ? (*arg.type)->flatten(flat)
+                                  : FlatModule::none });
+
+    FlatModule::Function fn;
+    fn.name    = m_name->symbol();
+    fn.params  = flat.add_params(params.data(), params.size());
+    fn.arity   = params.size();
+    fn.type    = m_type->flatten(flat);
+    fn.context = m_context ? (*m_context)->flatten(flat) : FlatModule::none;
+    fn.begin   = flat.nodes();
+    fn.body    = m_expr->flatten(flat);
+
+    flat.add_function(fn);
+  }
+
+
+  // The flat module
+
+  FlatModule::FlatModule(const Module &module) {
+    for (auto stmnt : module.statements())
+      stmnt->flatten(*this);
+  }
+
+  Index FlatModule::add_type(uint32_t name, const Index *args, size_t arity) {
+    Index first = m_type_args.size();
+    m_type_args.insert(m_type_args.end(), args, args + arity);
+
+    m_types.push_back({ name, first, (Index)arity });
+    return m_types.size() - 1;
+  }
+
+  Index FlatModule::add_params(const Param *params, size_t arity) {
+    Index first = m_params.size();
+    m_params.insert(m_params.end(), params, params + arity);
+    return first;
+  }
+
+  Index FlatModule::add_int(long long int val) {
+    m_kinds.push_back(IntLit);
+    m_lhs.push_back(m_ints.size());
+    m_rhs.push_back(none);
+
+    m_ints.push_back(val);
+    return m_kinds.size() - 1;
+  }
+
+  Index FlatModule::add_var(uint32_t name) {
+    m_kinds.push_back(Var);
+    m_lhs.push_back(name);
+    m_rhs.push_back(none);
+    return m_kinds.size() - 1;
+  }
+
+  Index FlatModule::add_call(uint32_t name, const Index *args, size_t arity) {
+    m_kinds.push_back(Call);
+    m_lhs.push_back(name);
+    m_rhs.push_back(m_call_args.size());
+
+    m_call_args.push_back(arity);
+    m_call_args.insert(m_call_args.end(), args, args + arity);
+    return m_kinds.size() - 1;
+  }
+
+  Index FlatModule::add_binop(char op, Index lhs, Index rhs) {
+    Kind kind;
+    switch (op) {
+    case '+': kind = Add; break;
+    case '-': kind = Sub; break;
+    case '*': kind = Mul; break;
+    case '/': kind = Div; break;
+    case '%': kind = Rem; break;
+    default:
+      throw Compiler::Error(std::string("Unknown operator ") + op);
+    }
+
+    m_kinds.push_back(kind);
+    m_lhs.push_back(lhs);
+    m_rhs.push_back(rhs);
+    return m_kinds.size() - 1;
+  }
+
+
+  // Printing, the same as the AST prints
+
+  std::ostream &operator<<(std::ostream &os, const FlatModule &module) {
+    return os << module.to_string();
+  }
+
+  std::string FlatModule::to_string() const {
+    std::stringstream r;
+
+    for (auto &fn : m_functions) {
+      r << Symbols::str(fn.name) << "(";
+
+      for (Index i = 0; i < fn.arity; i++) {
+        print_param(r, m_params[fn.params + i]);
+        if (i + 1 < fn.arity)
+          r << ", ";
+      }
+
+      r << ") ";
+      print_type(r, fn.type);
+
+      if (fn.context != none) {
+        r << " : ";
+        print_type(r, fn.context);
+      }
+
+      if (fn.body != none) {
+        r << " = ";
+        print_expr(r, fn.body);
+      }
+
+      r << ";\n";
+    }
+
+    return r.str();
+  }
+
+  void FlatModule::print_param(std::ostream &os, const Param &param) const {
+    if (param.name != none)
+      os << Symbols::str(param.name);
+    if (param.name != none && param.type != none)
+      os << " ";
+    if (param.type != none)
+      print_type(os, param.type);
+  }
+
+  void FlatModule::print_type(std::ostream &os, Index type) const {
+    const Type &t = m_types[type];
+
+    os << Symbols::str(t.name);
+    for (Index i = 0; i < t.arity; i++) {
+      os << ".(";
+      print_type(os, m_type_args[t.args + i]);
+      os << ")";
+    }
+  }
+
+  void FlatModule::print_expr(std::ostream &os, Index root) const {
+    struct Visit {
+      Index node;
+      Index next;
+    };
+    Parser::SmallVector<Visit, 16> todo;
+    todo.push_back({ root, 0 });
+
+    // operations as operands get parens, like BinOp::to_string()
+    auto nested = [&](Index node) { return m_kinds[node] >= Add; };
+    static constexpr char ops[] = { 0, 0, 0, '+', '-', '*', '/', '%' };
+
+    while (!todo.empty()) {
+      Index node = todo.back().node;
+      Index i = todo.back().next++;
+      Index lhs = m_lhs[node], rhs = m_rhs[node];
+
+      switch (m_kinds[node]) {
+      case IntLit:
+        os << m_ints[lhs];
+        break;
+
+      case Var:
+        os << Symbols::str(lhs);
+        break;
+
+      case Call: {
+        Index n = m_call_args[rhs];
+
+        if (i == 0)
+          os << Symbols::str(lhs) << "(";
+        else if (i < n)
+          os << ", ";
+
+        if (i < n) {
+          todo.push_back({ m_call_args[rhs + 1 + i], 0 });
+          continue;
+        }
+
+        os << ")";
+        break;
+      }
+
+      default:
+        if (i == 0 && nested(lhs))
+          os << "(";
+        if (i == 1) {
+          if (nested(lhs))
+            os << ")";
+          os << " " << ops[m_kinds[node]] << " ";
+          if (nested(rhs))
+            os << "(";
+        }
+        if (i == 2 && nested(rhs))
+          os << ")";
+
+        if (i < 2) {
+          todo.push_back({ i == 0 ? lhs : rhs, 0 });
+          continue;
+        }
+        break;
+      }
+
+      // done with the node after its last piece
+      todo.pop_back();
+    }
+  }
+
+
+  // The binary form
+
+  namespace {
+    constexpr char magic[4] = { 'F', 'Y', 'R', 'E' };
+    // bump on any change to the layout, and Cache::compiler on one to
+    // what goes in it. Written on a machine of the other byte order it
+    // reads as another version, so a mismatch too.
+    constexpr uint32_t version = 1;
+
+    struct Header {
+      char     magic[4];
+      uint32_t version;
+      uint64_t key;
+
+      // the string table: strings + 1 offsets into the chars
+      uint32_t strings;
+      uint32_t chars;
+
+      // the length of each array, in the order they follow
+      uint32_t nodes;
+      uint32_t ints;
+      uint32_t call_args;
+      uint32_t types;
+      uint32_t type_args;
+      uint32_t params;
+      uint32_t functions;
+      uint32_t reserved;
+    };
+
+    // every section starts aligned for anything in it, so it can be
+    // read in place
+    constexpr size_t align = 8;
+
+    size_t padded(size_t bytes) {
+      return (bytes + align - 1) / align * align;
+    }
+
+    template<class T>
+    void put(std::string &out, const T *data, size_t n) {
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "sections are written as they are in memory");
+      out.append((const char *)data, n * sizeof(T));
+      out.resize(padded(out.size()), '\0');
+    }
+
+    // takes the sections off the front of the data, once one doesn't
+    // fit all that follow are null
+    class Sections {
+    public:
+      Sections(const char *data, size_t size)
+        : m_at(data), m_left(size) {}
+
+      template<class T>
+      const T *take(size_t n) {
+        size_t bytes = padded(n * sizeof(T));
+        if (m_at == NULL || bytes > m_left) {
+          m_at = NULL;
+          return NULL;
+        }
+
+        const T *r = (const T *)m_at;
+        m_at   += bytes;
+        m_left -= bytes;
+        return r;
+      }
+
+      bool ok() const { return m_at != NULL; }
+
+    private:
+      const char *m_at;
+      size_t m_left;
+    };
+  }
+
+  void FlatModule::write(std::ostream &os, uint64_t key) const {
+    // the names used, each once, by the index they get in the file
+    std::unordered_map<Parser::Symbol, uint32_t> local;
+    std::vector<Parser::Symbol> names;
+    auto name = [&](Parser::Symbol s) -> uint32_t {
+      if (s == none)
+        return none;
+
+      auto it = local.emplace(s, names.size());
+      if (it.second)
+        names.push_back(s);
+      return it.first->second;
+    };
+
+    std::vector<Index> lhs(m_lhs);
+    for (size_t i = 0; i < m_kinds.size(); i++)
+      if (m_kinds[i] == Var || m_kinds[i] == Call)
+        lhs[i] = name(lhs[i]);
+
+    std::vector<Type> types(m_types);
+    for (auto &t : types)
+      t.name = name(t.name);
+
+    std::vector<Param> params(m_params);
+    for (auto &p : params)
+      p.name = name(p.name);
+
+    std::vector<Function> functions(m_functions);
+    for (auto &fn : functions)
+      fn.name = name(fn.name);
+
+    std::vector<uint32_t> offsets = { 0 };
+    std::string chars;
+    for (auto s : names) {
+      chars += Symbols::str(s);
+      offsets.push_back(chars.size());
+    }
+
+    Header h = {};
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version   = version;
+    h.key       = key;
+    h.strings   = names.size();
+    h.chars     = chars.size();
+    h.nodes     = m_kinds.size();
+    h.ints      = m_ints.size();
+    h.call_args = m_call_args.size();
+    h.types     = types.size();
+    h.type_args = m_type_args.size();
+    h.params    = params.size();
+    h.functions = functions.size();
+
+    std::string out;
+    put(out, &h, 1);
+    put(out, offsets.data(), offsets.size());
+    put(out, chars.data(), chars.size());
+    put(out, m_kinds.data(), m_kinds.size());
+    put(out, lhs.data(), lhs.size());
+    put(out, m_rhs.data(), m_rhs.size());
+    put(out, m_ints.data(), m_ints.size());
+    put(out, m_call_args.data(), m_call_args.size());
+    put(out, types.data(), types.size());
+    put(out, m_type_args.data(), m_type_args.size());
+    put(out, params.data(), params.size());
+    put(out, functions.data(), functions.size());
+
+    os.write(out.data(), out.size());
+  }
+
+  std::unique_ptr<FlatModule>
+  FlatModule::read(const char *data, size_t size, uint64_t key) {
+    if ((uintptr_t)data % align != 0)
+      return nullptr;
+
+    Sections in(data, size);
+    const Header *h = in.take<Header>(1);
+    if (h == NULL || std::memcmp(h->magic, magic, sizeof(magic)) != 0 ||
+        h->version != version || h->key != key)
+      return nullptr;
+
+    const uint32_t *offsets   = in.take<uint32_t>((size_t)h->strings + 1);
+    const char *chars         = in.take<char>(h->chars);
+    const Kind *kinds         = in.take<Kind>(h->nodes);
+    const Index *lhs          = in.take<Index>(h->nodes);
+    const Index *rhs          = in.take<Index>(h->nodes);
+    const long long int *ints = in.take<long long int>(h->ints);
+    const Index *call_args    = in.take<Index>(h->call_args);
+    const Type *types         = in.take<Type>(h->types);
+    const Index *type_args    = in.take<Index>(h->type_args);
+    const Param *params       = in.take<Param>(h->params);
+    const Function *functions = in.take<Function>(h->functions);
+    if (!in.ok())
+      return nullptr;
+
+    // everything read is checked to point where the writer would have
+    // pointed, so printing and codegen can trust it like a built one
+    bool bad = false;
+    auto check = [&](bool ok) { bad |= !ok; };
+
+    std::vector<Parser::Symbol> symbols(h->strings);
+    for (uint32_t i = 0; i < h->strings && !bad; i++) {
+      check(offsets[i] <= offsets[i + 1] && offsets[i + 1] <= h->chars);
+      if (!bad)
+        symbols[i] = Symbols::intern(std::string_view(chars + offsets[i],
+                                                      offsets[i + 1] -
+                                                      offsets[i]));
+    }
+    auto symbol = [&](Index i, bool optional = false) -> Parser::Symbol {
+      if (i < symbols.size())
+        return symbols[i];
+
+      check(optional && i == none);
+      return none;
+    };
+
+    auto flat = std::make_unique<FlatModule>();
+    flat->m_kinds.assign(kinds, kinds + h->nodes);
+    flat->m_lhs.assign(lhs, lhs + h->nodes);
+    flat->m_rhs.assign(rhs, rhs + h->nodes);
+    flat->m_ints.assign(ints, ints + h->ints);
+    flat->m_call_args.assign(call_args, call_args + h->call_args);
+    flat->m_types.assign(types, types + h->types);
+    flat->m_type_args.assign(type_args, type_args + h->type_args);
+    flat->m_params.assign(params, params + h->params);
+    flat->m_functions.assign(functions, functions + h->functions);
+
+    // operands come before the nodes using them
+    for (Index i = 0; i < h->nodes && !bad; i++) {
+      Index &l = flat->m_lhs[i];
+      Index r = flat->m_rhs[i];
+
+      switch (flat->m_kinds[i]) {
+      case IntLit:
+        check(l < h->ints);
+        break;
+
+      case Var:
+        l = symbol(l);
+        break;
+
+      case Call:
+        l = symbol(l);
+        check(r < h->call_args && call_args[r] < h->call_args - r);
+        for (Index k = 0; !bad && k < call_args[r]; k++)
+          check(call_args[r + 1 + k] < i);
+        break;
+
+      case Add: case Sub: case Mul: case Div: case Rem:
+        check(l < i && r < i);
+        break;
+
+      default:
+        bad = true;
+      }
+    }
+
+    // and so do the arguments of a type
+    for (Index i = 0; i < h->types && !bad; i++) {
+      Type &t = flat->m_types[i];
+      t.name = symbol(t.name);
+
+      check((uint64_t)t.args + t.arity <= h->type_args);
+      for (Index k = 0; !bad && k < t.arity; k++)
+        check(type_args[t.args + k] < i);
+    }
+
+    for (auto &p : flat->m_params) {
+      p.name = symbol(p.name, true);
+      check(p.type == none || p.type < h->types);
+    }
+
+    for (auto &fn : flat->m_functions) {
+      if (bad)
+        break;
+
+      fn.name = symbol(fn.name);
+      check((uint64_t)fn.params + fn.arity <= h->params);
+      check(fn.type < h->types);
+      check(fn.context == none || fn.context < h->types);
+
+      // a body is a run of nodes only referring to each other
+      if (fn.body == none) {
+        check(fn.begin == none);
+        continue;
+      }
+
+      check(fn.begin <= fn.body && fn.body < h->nodes);
+      for (Index i = fn.begin; !bad && i <= fn.body; i++) {
+        Index l = flat->m_lhs[i], r = flat->m_rhs[i];
+
+        switch (flat->m_kinds[i]) {
+        case Call:
+          for (Index k = 0; k < flat->m_call_args[r]; k++)
+            check(flat->m_call_args[r + 1 + k] >= fn.begin);
+          break;
+
+        case IntLit: case Var:
+          break;
+
+        default:
+          check(l >= fn.begin && r >= fn.begin);
+        }
+      }
+    }
+
+    if (bad)
+      return nullptr;
+    return flat;
+  }
+
+}
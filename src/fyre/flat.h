@@ -0,0 +1,114 @@
+#ifndef FYRE_FLAT_H
+#define FYRE_FLAT_H
+
+#include <string>
+#include <ostream>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "AST.h"
+#include "context.h"
+
+namespace Fyre {
+
+  /// A Module laid out in flat arrays
+
+  /// Nodes are referred to by 32-bit indices into arrays of their kind,
+  /// names by their Parser::Symbols id. Expression nodes are stored
+  /// children first, the nodes of a function body being one run that
+  /// ends with its root, so codegen is a single loop over the run. The
+  /// pointer AST can go once this is built: it holds no pointers into
+  /// it.
+  class FlatModule {
+  public:
+    using Index = uint32_t;
+    static constexpr Index none = ~(Index)0;
+
+    /// What an expression node is, the operator for a BinOp
+    enum Kind : uint8_t { IntLit, Var, Call, Add, Sub, Mul, Div, Rem };
+
+    struct Type {
+      uint32_t name;
+      // a run of `arity` in m_type_args
+      Index args;
+      Index arity;
+    };
+
+    /// An argument of a FunDec or FunDef, either part may be none
+    struct Param {
+      uint32_t name;
+      Index type;
+    };
+
+    /// A FunDec, or a FunDef if it has a body
+    struct Function {
+      uint32_t name;
+      // a run of `arity` in m_params
+      Index params;
+      Index arity;
+      Index type;
+      Index context;
+      // the nodes of the body are [begin, body], body is its root
+      Index begin;
+      Index body;
+    };
+
+    FlatModule() = default;
+    FlatModule(const Module &module);
+
+    std::string to_string() const;
+    std::unique_ptr<ContextRoot> codegen(const std::string &) const;
+
+    const std::vector<Function> &functions() const { return m_functions; }
+    size_t nodes() const { return m_kinds.size(); }
+
+    /// The binary form: a versioned header, a string table of the names
+    /// and the arrays as they are in memory, with names as indices into
+    /// the string table. `key` identifies the source it was made from.
+    void write(std::ostream &os, uint64_t key) const;
+    /// Read back what write() wrote for `key`, null when `data` is
+    /// anything else: another key or version, or a damaged file
+    static std::unique_ptr<FlatModule> read(const char *data, size_t size,
+                                            uint64_t key);
+
+    /// Appending, the nodes of a Module use these to lay themselves out
+    Index add_type(uint32_t name, const Index *args, size_t arity);
+    Index add_params(const Param *params, size_t arity);
+    void add_function(const Function &fn) { m_functions.push_back(fn); }
+
+    Index add_int(long long int val);
+    Index add_var(uint32_t name);
+    Index add_call(uint32_t name, const Index *args, size_t arity);
+    Index add_binop(char op, Index lhs, Index rhs);
+
+  private:
+    void print_type(std::ostream &os, Index type) const;
+    void print_expr(std::ostream &os, Index root) const;
+    void print_param(std::ostream &os, const Param &param) const;
+
+    llvm::Type *codegen_type(Context &ctx, Index type) const;
+    // `values` is scratch space for the values of body nodes
+    llvm::Function *codegen_function(Context &ctx, const Function &fn,
+                                     std::vector<llvm::Value *> &values) const;
+
+    // expression nodes, an IntLit's lhs is its index in m_ints, a Var's
+    // and a Call's its name, a Call's rhs is where its arguments start
+    // in m_call_args, the count first
+    std::vector<Kind>  m_kinds;
+    std::vector<Index> m_lhs;
+    std::vector<Index> m_rhs;
+    std::vector<long long int> m_ints;
+    std::vector<Index> m_call_args;
+
+    std::vector<Type>  m_types;
+    std::vector<Index> m_type_args;
+    std::vector<Param> m_params;
+    std::vector<Function> m_functions;
+  };
+
+  std::ostream &operator<<(std::ostream &os, const FlatModule &module);
+
+}
+
+#endif
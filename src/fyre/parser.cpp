@@ -1,268 +1,603 @@
 #include <parser/parser.h>
+#include <parser/grammar.h>
+#include <parser/precedence.h>
+#include <parser/lexer.h>
+#include <parser/symbols.h>
+#include <parser/scan.h>
 
 #include "parser.h"
 #include "AST.h"
 
 #include <sstream>
+#include <charconv>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <algorithm>
 
 using std::shared_ptr;
 using std::make_shared;
 
 using Parser::CharSet;
+using Parser::Token;
+namespace Symbols = Parser::Symbols;
 // Actual parsing
 
 namespace Fyre {
 
   namespace Sets {
-#define from_std(pred, desc)                                            \
-    const CharSet pred = {desc, [](char c){ return (bool)std::pred(c); }};
-
-    from_std(isupper, "upper-case")
-    from_std(islower, "lower-case")
-    from_std(isalnum, "alphanumeric")
-    from_std(isdigit, "digit")
-
-#undef from_std
+    constexpr CharSet isupper = CharSet::range('A', 'Z', "upper-case");
+    constexpr CharSet islower = CharSet::range('a', 'z', "lower-case");
+    constexpr CharSet isdigit = CharSet::range('0', '9', "digit");
+    constexpr CharSet isalnum =
+      CharSet("alphanumeric", CharSet(isupper, islower, isdigit));
+
+    constexpr CharSet ident_head = {'_', islower};
+    constexpr CharSet ident_tail = {'_', isalnum};
+
+    constexpr CharSet lparen = {'('};
+    constexpr CharSet rparen = {')'};
+    constexpr CharSet comma  = {','};
   }
+}
 
-  // namespace FyreParser {
-
-  namespace ExtraParsers {
-    template<class Enc>
-    struct Encloser {
-      static const CharSet lhs;
-      static const CharSet rhs;
-    };
-
-    template<class Parsable, class Enc>
-    struct Enclosed {
-      static auto parse(Parser::IParseStream &in) {
-        in.begin_token();
-        in.one_of(Encloser<Enc>::lhs);
+// what operands and the alternatives of TopLvl can start with
+template<> struct Parser::First<Fyre::FunCal> {
+  static constexpr CharSet set = Fyre::Sets::ident_head;
+};
+template<> struct Parser::First<Fyre::IntLit> {
+  static constexpr CharSet set = Fyre::Sets::isdigit;
+};
+template<> struct Parser::First<Fyre::FunDef> {
+  static constexpr CharSet set = Fyre::Sets::ident_head;
+};
+template<> struct Parser::First<Fyre::FunDec> {
+  static constexpr CharSet set = Fyre::Sets::ident_head;
+};
 
-        auto r = in.one_of<Parsable>();
+namespace Fyre {
 
-        in.begin_token();
-        in.one_of(Encloser<Enc>::rhs);
-        return r;
-      }
-    };
+  // bind the result of a parse, or hand its failure up
+#define try_parse(var, ...)                     \
+  auto var = (__VA_ARGS__);                     \
+  if (!var)                                     \
+    return var.failure();
 
-    struct EParens;
+  // namespace FyreParser {
 
-    template<> const CharSet Encloser<EParens>::lhs = {'('};
-    template<> const CharSet Encloser<EParens>::rhs = {')'};
+  namespace ExtraParsers {
+    using Parser::Char;
+    using Parser::Enclosed;
+    using Parser::SepBy;
 
     template<class P>
-    using Parens = Enclosed<P, EParens>;
-
-    template<class Sep>
-    struct Separator {
-      static const CharSet sep;
-    };
-
-    template<class Parsable, class Sep>
-    struct SepBy {
-      static auto parse(Parser::IParseStream &in) {
-        std::vector<typename Parser::ParsableTrait<Parsable>::ResultType> r;
-
-        // NOTE: accepts trailing separator
-        for (;;) {
-          auto e = in.maybe_of<Parsable>();
-          if (!e)
-            break;
-
-          r.push_back(*e);
-
-          auto s = in.maybe_of(Separator<Sep>::sep);
-          if (!s)
-            break;
-        }
-
-        return r;
-      }
-    };
+    using Parens = Enclosed<Char<Sets::lparen>, P, Char<Sets::rparen>>;
 
-    struct SComma;
+    using SComma = Char<Sets::comma>;
 
-    template<> const CharSet Separator<SComma>::sep = {','};
+    // collects arguments before they go in the arena, most functions
+    // take only a few
+    template<class Arg>
+    using ArgList = Parser::SmallVector<Arg, 4>;
 
     struct TypeIdent {
-      static std::string parse(Parser::IParseStream &in) {
-        std::stringstream r;
-
-        r << in.one_of ({Sets::isupper})
-          << in.many_of({'_', Sets::isalnum});
+      static Parser::Result<Parser::Symbol> parse(Parser::TokenCursor &in) {
+        try_parse(t, in.one_of(Token::Word, Sets::isupper));
 
-        return r.str();
+        return t->payload;
       }
     };
 
     struct TypeNoArgs {
-      static TypePtr parse(Parser::IParseStream &in) {
-        auto id = in.one_of<ExtraParsers::TypeIdent>();
+      static Parser::Result<TypePtr> parse(Parser::TokenCursor &in) {
+        try_parse(id, in.one_of<ExtraParsers::TypeIdent>());
 
-        return make_shared<Type>(id);
+        return in.arena().make<Type>(*id);
       }
     };
 
     struct TypeArg {
-      static TypePtr parse(Parser::IParseStream &in) {
-        in.begin_token();
-        in.one_of({'.'});
-
-        auto typ = in.one_of<Parens<Type>, TypeNoArgs>();
+      static Parser::Result<TypePtr> parse(Parser::TokenCursor &in) {
+        try_parse(dot, in.one_of({'.'}));
 
-        return typ;
+        return in.one_of<Parens<Type>, TypeNoArgs>();
       }
     };
 
     struct FunDecArg {
-      static FunDec::Arg parse(Parser::IParseStream &in) {
+      static Parser::Result<FunDec::Arg> parse(Parser::TokenCursor &in) {
 
         auto name = in.maybe_of<Ident>();
-        auto type = in.one_of<Type>();
+        try_parse(type, in.one_of<Type>());
 
-        return { name, type };
+        return FunDec::Arg{ std::move(name), std::move(*type) };
       }
     };
 
     struct FunDefArg {
-      static FunDef::Arg parse(Parser::IParseStream &in) {
+      static Parser::Result<FunDef::Arg> parse(Parser::TokenCursor &in) {
 
-        auto name = in.one_of<Ident>();
+        try_parse(name, in.one_of<Ident>());
         auto type = in.maybe_of<Type>();
 
-        return { name, type };
+        return FunDef::Arg{ std::move(*name), std::move(type) };
       }
     };
 
-    struct FunCalArg {
-      static FunCal::Arg parse(Parser::IParseStream &in) {
+    struct Arith {
+      static constexpr Parser::Operators operators = Parser::Operators()
+        .infix('+', 1).infix('-', 1)
+        .infix('*', 2).infix('/', 2).infix('%', 2)
+        .prefix('-', 3);
 
-        auto name = in.one_of<Expr>();
+      static ExprPtr infix(Parser::TokenCursor &in,
+                           char op, ExprPtr lhs, ExprPtr rhs) {
+        return in.arena().make<BinOp>(op, lhs, rhs);
+      }
 
-        return name;
+      // -x is 0 - x
+      static ExprPtr prefix(Parser::TokenCursor &in, char op, ExprPtr e) {
+        return in.arena().make<BinOp>(op, in.arena().make<IntLit>(0), e);
       }
     };
+
+    using ArithStack = Parser::OperatorStack<Arith, ExprPtr>;
+
+    // a call or parenthesized expression that hasn't been closed yet
+    struct Nest {
+      // the expression it is an operand of, so far
+      ArithStack outer;
+      // what is called, null for parentheses
+      IdentPtr callee;
+      ArgList<FunCal::Arg> args;
+    };
   }
 
-  IdentPtr Ident::parse(Parser::IParseStream &in) {
-    std::stringstream r;
+  Parser::Result<IdentPtr> Ident::parse(Parser::TokenCursor &in) {
+    try_parse(t, in.one_of(Token::Word, Sets::ident_head));
+
+    return in.arena().make<Ident>(t->payload);
+  }
 
-    in.begin_token();
+  Parser::Result<TypePtr> Type::parse(Parser::TokenCursor &in) {
+    try_parse(id, in.one_of<ExtraParsers::TypeIdent>());
 
-    r << in.one_of ({'_', Sets::islower})
-      << in.many_of({'_', Sets::isalnum});
+    auto args = in.many_of<ExtraParsers::TypeArg>();
 
-    return make_shared<Ident>(r.str());
+    return in.arena().make<Type>(*id, in.arena().copy(args));
   }
 
-  TypePtr Type::parse(Parser::IParseStream &in) {
-    std::stringstream r;
+  // Calls and parentheses nest on a stack of their own instead of being
+  // parsed recursively, so only memory limits how deep they can go.
+  Parser::Result<ExprPtr> Expr::parse(Parser::TokenCursor &in) {
+    using namespace ExtraParsers;
+    using Parser::First;
 
-    in.begin_token();
+    Parser::SmallVector<Nest, 4> nests;
+    ArithStack expr;
 
-    // r << ExtraParsers::TypeIdent>::parse(in);
-    r << in.one_of<ExtraParsers::TypeIdent>();
+    for (;;) {
+      // an operand, or the start of one that nests
+      expr.prefixes(in);
 
-    std::vector<TypePtr> args =
-      in.many_of<ExtraParsers::TypeArg>();
+      ExprPtr e;
+      int c = in.lookahead();
 
-    return make_shared<Type>(r.str(), args);
-  }
+      if (c != EOF && First<FunCal>::set.contains(c)) {
+        try_parse(id, in.one_of<Ident>());
+
+        if (!in.maybe_of(Sets::lparen))
+          e = in.arena().make<Var>(*id);
+        else if (in.maybe_of(Sets::rparen))
+          e = in.arena().make<FunCal>(*id, FunCal::Args());
+        else {
+          nests.push_back({ std::move(expr), *id, {} });
+          expr = ArithStack();
+          continue;
+        }
 
-  ExprPtr Expr::parse(Parser::IParseStream &in) {
+      } else if (c != EOF && First<IntLit>::set.contains(c)) {
+        try_parse(lit, in.one_of<IntLit>());
+        e = *lit;
 
-    return in.one_of_as<ExprPtr, FunCal, Var, IntLit>();
+      } else if (in.maybe_of(Sets::lparen)) {
+        nests.push_back({ std::move(expr), nullptr, {} });
+        expr = ArithStack();
+        continue;
 
-    // return in.one_of<FunCal, IntLit>();
-  }
+      } else {
+        // let the other operands note they were expected here too
+        in.maybe_of(Token::Word, First<FunCal>::set);
+        in.maybe_of(Token::Number, First<IntLit>::set);
+        return Parser::Failure();
+      }
+
+      // operators after it, or the end of the expression, which may be
+      // an operand of the one it is nested in
+      for (;;) {
+        expr.operand(std::move(e));
+        if (expr.infix(in))
+          break;
+
+        ExprPtr done = expr.finish(in);
+        if (nests.empty())
+          return done;
+
+        Nest &nest = nests.back();
 
-  IntLitPtr IntLit::parse(Parser::IParseStream &in) {
-    std::stringstream r;
-    in.begin_token();
+        if (!nest.callee) {
+          try_parse(rp, in.one_of(Sets::rparen));
+          e = std::move(done);
 
-    r << in.one_of ({Sets::isdigit})
-      << in.many_of({Sets::isdigit});
+        } else {
+          nest.args.push_back(std::move(done));
 
-    long long int v = std::stoi(r.str());
-    return make_shared<IntLit>(v);
+          // NOTE: accepts a trailing comma
+          bool more = in.maybe_of(Sets::comma).has_value();
+          if (!in.maybe_of(Sets::rparen)) {
+            if (!more)
+              return Parser::Failure();
+
+            expr = ArithStack();
+            break;
+          }
+
+          e = in.arena().make<FunCal>(nest.callee,
+                                      in.arena().copy(nest.args));
+        }
+
+        expr = std::move(nest.outer);
+        nests.pop_back();
+      }
+    }
   }
 
-  VarPtr Var::parse(Parser::IParseStream &in) {
-    auto id = in.one_of<Ident>();
+  Parser::Result<IntLitPtr> IntLit::parse(Parser::TokenCursor &in) {
+    auto pos = in.tell();
+
+    try_parse(t, in.one_of(Token::Number, Sets::isdigit));
+    auto digits = Symbols::str(t->payload);
+
+    long long int v;
+    auto r = std::from_chars(digits.data(), digits.data() + digits.size(), v);
+    if (r.ec != std::errc()) {
+      in.seek(pos);
+      return in.fail("Integer literal out of range: " + std::string(digits));
+    }
 
-    return make_shared<Var>(id);
+    return in.arena().make<IntLit>(v);
   }
 
-  FunDecPtr FunDec::parse(Parser::IParseStream &in) {
+  Parser::Result<FunDecPtr> FunDec::parse(Parser::TokenCursor &in) {
     using namespace ExtraParsers;
 
-    auto id   = in.one_of<Ident>();
+    try_parse(id,   in.one_of<Ident>());
 
-    auto args = in.one_of<Parens<SepBy<FunDecArg, SComma>>>();
+    try_parse(args, in.one_of<Parens<SepBy<FunDecArg, SComma,
+                                           ArgList<Arg>>>>());
 
-    auto type = in.one_of<Type>();
+    try_parse(type, in.one_of<Type>());
 
-    return make_shared<FunDec>(id, args, type);
+    return in.arena().make<FunDec>(*id, in.arena().copy(*args), *type);
   }
 
-  FunDefPtr FunDef::parse(Parser::IParseStream &in) {
+  Parser::Result<FunDefPtr> FunDef::parse(Parser::TokenCursor &in) {
     using namespace ExtraParsers;
 
-    auto id   = in.one_of<Ident>();
+    try_parse(id,   in.one_of<Ident>());
 
-    auto args = in.one_of<Parens<SepBy<FunDefArg, SComma>>>();
+    try_parse(args, in.one_of<Parens<SepBy<FunDefArg, SComma,
+                                           ArgList<Arg>>>>());
 
-    auto type = in.one_of<Type>();
+    try_parse(type, in.one_of<Type>());
 
-    in.begin_token();
-    in.one_of({'='});
+    try_parse(eq,   in.one_of({'='}));
 
-    auto expr = in.one_of<Expr>();
+    try_parse(expr, in.one_of<Expr>());
 
-    return make_shared<FunDef>(id, args, type, std::nullopt, expr);
+    return in.arena().make<FunDef>(*id, in.arena().copy(*args),
+                                   *type, std::nullopt, *expr);
   }
 
-  FunCalPtr FunCal::parse(Parser::IParseStream &in) {
-    using namespace ExtraParsers;
+  Parser::Result<TopLvlPtr> TopLvl::parse(Parser::TokenCursor &in) {
+    return Parser::ParserSet<TopLvlPtr, FunDef, FunDec>::parse(in);
+  }
+
+  // parse statements up to the end of the input, or up to the first
+  // offset `stop` says is the start of a statement that's known already,
+  // handing each to `emit` with its Span as soon as it's parsed
+  template<class Stop, class Emit>
+  static Parser::Result<size_t>
+  each_statement(Parser::TokenCursor &in, Stop stop, Emit emit) {
+    size_t n = 0;
+
+    while (!in.eof()) {
+      uint32_t start = in.get_loc().offset;
+      if (stop(start))
+        break;
+
+      auto s = in.one_of<TopLvl>();
+
+      if (!s && !in.maybe_of({';'}))
+        return s.failure();
+
+      if (s) {
+        emit(std::move(*s),
+             Module::Span{ start, in.end_offset() - start, in.reach() });
+        n++;
+      }
 
-    auto id   = in.one_of<Ident>();
-    auto args = in.one_of<Parens<SepBy<FunCalArg, SComma>>>();
+      // statements are never backtracked into, so let the input go
+      in.commit();
+    }
 
-    return make_shared<FunCal>(id, args);
+    return n;
   }
 
-  TopLvlPtr TopLvl::parse(Parser::IParseStream &in) {
-    return in.one_of_as<TopLvlPtr, FunDef, FunDec>();
+  static bool never(uint32_t) { return false; }
+
+  // statements and where they are
+  struct Statements {
+    std::vector<TopLvlPtr> stmnts;
+    std::vector<Module::Span> spans;
+  };
+
+  template<class Stop>
+  static Parser::Result<Statements>
+  parse_statements(Parser::TokenCursor &in, Stop stop) {
+    Statements r;
+
+    try_parse(n, each_statement(in, stop, [&](TopLvlPtr s, Module::Span span) {
+      r.stmnts.push_back(std::move(s));
+      r.spans.push_back(span);
+    }));
+
+    return r;
   }
 
-  ModulePtr Module::parse(Parser::IParseStream &in) {
-    std::vector<TopLvlPtr> r;
+  static Parser::Result<Statements>
+  parse_statements(Parser::TokenCursor &in) {
+    return parse_statements(in, never);
+  }
 
-    in.skip_ws();
-    while (in.peek() != EOF) {
-      try {
+  Parser::Result<ModulePtr> Module::parse(Parser::TokenCursor &in) {
+    try_parse(r, parse_statements(in));
 
-        r.push_back(in.one_of<TopLvl>());
+    return make_shared<Module>(std::move(r->stmnts), std::move(r->spans),
+                               in.file(), Arenas{ in.share_arena() });
+  }
 
-      } catch (Parser::Error e) {
+  Parser::Result<size_t>
+  Module::stream(Parser::TokenCursor &in,
+                 const std::function<void(ModulePtr)> &sink) {
+    // a fresh arena for every statement, that goes with it
+    in.set_arena(nullptr);
+
+    return each_statement(in, never, [&](TopLvlPtr s, Span span) {
+      sink(make_shared<Module>(std::vector<TopLvlPtr>{ s },
+                               std::vector<Span>{ span }, in.file(),
+                               Arenas{ in.share_arena() }));
+      in.set_arena(nullptr);
+    });
+  }
 
-        in.skip_ws();
+  ModulePtr Module::reparse(std::string_view src, const Edit &edit) const {
+    uint32_t edit_end = edit.offset + edit.removed;
+    int64_t delta = (int64_t)edit.inserted.size() - edit.removed;
+
+    // Statements are only kept if their parse never looked at anything
+    // the edit touches. One whose last token ends right where the edit
+    // starts may still change, `f` + `oo` is `foo`.
+    size_t first = std::partition_point(m_spans.begin(), m_spans.end(),
+                                        [&](const Span &span) {
+                                          return span.reach < edit.offset;
+                                        }) - m_spans.begin();
+
+    uint32_t from = first > 0 ? m_spans[first - 1].end() : 0;
+
+    // the new version of the input is only put in the file table if
+    // it doesn't parse, to show where, an editor reparses every
+    // keystroke
+    Parser::ParseCursor chunk(src.substr(from), m_file, from);
+    Parser::TokenCursor toks(chunk);
+
+    // Stop at the first old statement past the edit the new statements
+    // line up with. The lexer only looks forward, so from there on the
+    // tokens and so the statements are the same as before.
+    size_t next = first;
+    auto known = [&](uint32_t offset) {
+      while (next < m_spans.size() &&
+             (m_spans[next].offset <= edit_end ||
+              m_spans[next].offset + delta < offset))
+        next++;
+
+      return next < m_spans.size() && m_spans[next].offset + delta == offset;
+    };
 
-        if(!in.maybe_of({';'}))
-          throw e;
+    Parser::Result<Statements> r = Parser::Failure();
+    try {
+      r = parse_statements(toks, known);
+      if (!r)
+        throw toks.error();
+
+    } catch (Parser::Error &e) {
+      uint32_t file = Parser::Files::add(Parser::Files::name(m_file));
+      Parser::Files::index(file, 0, src.data(), src.data() + src.size());
+      e.relocate(file);
+      throw;
+    }
 
-        in.skip_ws();
+    std::vector<TopLvlPtr> stmnts(m_statements.begin(),
+                                  m_statements.begin() + first);
+    std::vector<Span> spans(m_spans.begin(), m_spans.begin() + first);
+
+    stmnts.insert(stmnts.end(),
+                  std::make_move_iterator(r->stmnts.begin()),
+                  std::make_move_iterator(r->stmnts.end()));
+    spans.insert(spans.end(), r->spans.begin(), r->spans.end());
+
+    // if the parse stopped early the rest is the same, just moved
+    if (!toks.eof()) {
+      for (size_t i = next; i < m_spans.size(); i++) {
+        stmnts.push_back(m_statements[i]);
+        spans.push_back({ (uint32_t)(m_spans[i].offset + delta),
+                          m_spans[i].length,
+                          (uint32_t)(m_spans[i].reach + delta) });
       }
+    }
 
+    // the statements kept stay where they are
+    Arenas arenas = m_arenas;
+    arenas.push_back(toks.share_arena());
+
+    return make_shared<Module>(std::move(stmnts), std::move(spans), m_file,
+                               std::move(arenas));
+  }
+
+  // Whether a statement starts at `c`, which begins a line: a name and
+  // its parenthesized arguments, then its type on the same line. No
+  // expression looks like that, a call is never followed by a name.
+  static bool statement_head(const char *c, const char *end) {
+    if (c == end || !Sets::ident_head.contains(*c))
+      return false;
+    while (++c < end && Sets::ident_tail.contains(*c))
+      ;
+    if (c == end || *c != '(')
+      return false;
+
+    unsigned int depth = 0;
+    for (; c < end && *c != '\n'; c++) {
+      if (*c == '(')
+        depth++;
+      else if (*c == ')' && --depth == 0)
+        break;
     }
+    if (c == end || *c != ')')
+      return false;
 
-    return make_shared<Module>(r);
+    while (++c < end && (*c == ' ' || *c == '\t'))
+      ;
+    return c < end && Sets::isupper.contains(*c);
   }
 
-}
+  // Whether what comes before `c` can end a statement, a name, number or
+  // closing paren and not an operator waiting for its operand
+  static bool statement_tail(const char *beg, const char *c) {
+    while (c > beg && Parser::Scan::whitespace.contains(c[-1]))
+      c--;
+    return c > beg && (Sets::ident_tail.contains(c[-1]) || c[-1] == ')');
+  }
+
+  std::vector<size_t> Module::split(std::string_view src, size_t pieces) {
+    // everything that can't end a statement
+    constexpr CharSet inert = CharSet("", [](char c) {
+      return c != '(' && c != ')' && c != ';' && c != '\n';
+    });
+
+    // A `;` outside any parens always ends a statement, and so does a
+    // newline there that's followed by the head of the next one
+    size_t target = src.size() / pieces + 1;
+    std::vector<size_t> cuts = { 0 };
+    unsigned int depth = 0;
+
+    for (const char *c = src.data(), *end = c + src.size();
+         (c = Parser::Scan::span(inert, c, end)) < end; c++) {
+      if (*c == '(')
+        depth++;
+      else if (*c == ')')
+        depth -= depth > 0;
+      else if (depth > 0 || c + 1 - src.data() - cuts.back() < target)
+        continue;
+      else if (*c == ';' ||
+               (statement_head(c + 1, end) && statement_tail(src.data(), c)))
+        cuts.push_back(c + 1 - src.data());
+    }
+    cuts.push_back(src.size());
+
+    return cuts;
+  }
 
+  ModulePtr Module::parse_parallel(Parser::ParseCursor &in, unsigned jobs) {
+    std::string_view src = in.rest();
+    size_t base = in.tell();
+
+    // a few chunks per job, so one slow chunk doesn't hold everything up
+    std::vector<size_t> cuts = split(src, jobs * 4);
+
+    size_t n = cuts.size() - 1;
+    std::vector<Statements> parts(n);
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<Parser::ParseStats> stats(n);
+    Arenas arenas(n);
+    std::atomic<size_t> next(0);
+
+    // the budget is for the whole input, what the chunks do adds up
+    Parser::SharedStats shared;
+    shared.rewinds   = in.stats().rewinds;
+    shared.rescanned = in.stats().rescanned;
+    Parser::Budget budget = in.budget();
+    budget.shared = &shared;
+
+    auto work = [&]() {
+      for (size_t i; (i = next++) < n;) {
+        // a chunk sees the rest of the input, so its last statement
+        // looks as far past it as in a sequential parse, and stops at
+        // the next chunk
+        Parser::ParseCursor chunk(src.substr(cuts[i]), in.file(),
+                                  base + cuts[i]);
+        Parser::TokenCursor toks(chunk);
+        toks.set_budget(budget);
+
+        auto next_chunk = [&](uint32_t offset) {
+          return offset >= base + cuts[i+1];
+        };
+
+        try {
+          auto r = parse_statements(toks, next_chunk);
+          if (r)
+            parts[i] = std::move(*r);
+          else
+            errors[i] = std::make_exception_ptr(toks.error());
+
+        } catch (...) {
+          // let nothing out of a thread, that would end the program
+          errors[i] = std::current_exception();
+        }
+        stats[i] = toks.stats();
+        arenas[i] = toks.share_arena();
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < std::min<size_t>(jobs, n); i++)
+      threads.emplace_back(work);
+    work();
+    for (auto &t : threads)
+      t.join();
+
+    for (auto &s : stats)
+      in.add_stats(s);
+
+    std::vector<TopLvlPtr> r;
+    std::vector<Span> spans;
+    for (size_t i = 0; i < n; i++) {
+      // report the first error in the input, like a sequential parse,
+      // whatever it was
+      if (errors[i])
+        std::rethrow_exception(errors[i]);
+
+      r.insert(r.end(), parts[i].stmnts.begin(), parts[i].stmnts.end());
+      spans.insert(spans.end(), parts[i].spans.begin(), parts[i].spans.end());
+    }
+
+    in.seek(base + src.size());
+
+    return make_shared<Module>(std::move(r), std::move(spans), in.file(),
+                               std::move(arenas));
+  }
+
+#undef try_parse
+
+}
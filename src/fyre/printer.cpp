@@ -0,0 +1,416 @@
+#include "printer.h"
+
+#include <cstdio>
+
+#include <parser/symbols.h>
+#include <parser/small_vector.h>
+
+namespace Symbols = Parser::Symbols;
+
+namespace Fyre {
+  namespace {
+    // the parts of either kind of argument, null where there's none
+    const Ident *name_of(const FunDec::Arg &arg) {
+      return arg.name ? *arg.name : nullptr;
+    }
+    const Ident *name_of(const FunDef::Arg &arg) { return arg.name; }
+
+    const Type *type_of(const FunDec::Arg &arg) { return arg.type; }
+    const Type *type_of(const FunDef::Arg &arg) {
+      return arg.type ? *arg.type : nullptr;
+    }
+
+    std::ostream &operator<<(std::ostream &os, const Ident &id) {
+      return os << Symbols::str(id.symbol());
+    }
+  }
+
+  void Printer::print(const Module &module) {
+    begin();
+    for (auto stmnt : module.statements())
+      statement(*stmnt);
+    end();
+  }
+
+  void Printer::print(const Expr &expr) {
+    struct Visit {
+      const Expr *expr;
+      size_t next;
+    };
+    Parser::SmallVector<Visit, 16> todo;
+    todo.push_back({ &expr, 0 });
+
+    while (!todo.empty()) {
+      const Expr *e = todo.back().expr;
+      size_t i = todo.back().next++;
+
+      e->accept(*this, i);
+
+      if (i < e->operands())
+        todo.push_back({ &e->operand(i), 0 });
+      else
+        todo.pop_back();
+    }
+  }
+
+  void FunDec::accept(Printer &printer) const {
+    printer.visit(*this);
+  }
+
+  void FunDef::accept(Printer &printer) const {
+    printer.visit(*this, 0);
+    printer.print(*m_expr);
+    printer.visit(*this, 1);
+  }
+
+  void IntLit::accept(Printer &printer, size_t i) const {
+    printer.visit(*this, i);
+  }
+
+  void Var::accept(Printer &printer, size_t i) const {
+    printer.visit(*this, i);
+  }
+
+  void FunCal::accept(Printer &printer, size_t i) const {
+    printer.visit(*this, i);
+  }
+
+  void BinOp::accept(Printer &printer, size_t i) const {
+    printer.visit(*this, i);
+  }
+
+
+  // Fyre source
+
+  void SourcePrinter::print(const Type &type) {
+    m_os << Symbols::str(type.symbol());
+    for (auto arg : type.args()) {
+      m_os << ".(";
+      print(*arg);
+      m_os << ")";
+    }
+  }
+
+  void SourcePrinter::statement(const TopLvl &stmnt) {
+    print(stmnt);
+    m_os << ";\n";
+  }
+
+  void SourcePrinter::visit(const FunDec &fn) {
+    m_os << *fn.name() << "(";
+
+    for (auto &arg : fn.args()) {
+      if (arg.name)
+        m_os << **arg.name << " ";
+      print(*arg.type);
+
+      if (&arg < &fn.args().back())
+        m_os << ", ";
+    }
+
+    m_os << ") ";
+    print(*fn.type());
+
+    if (fn.context()) {
+      m_os << " : ";
+      print(**fn.context());
+    }
+  }
+
+  void SourcePrinter::visit(const FunDef &fn, size_t i) {
+    if (i > 0)
+      return;
+
+    m_os << *fn.name() << "(";
+
+    for (auto &arg : fn.args()) {
+      m_os << *arg.name;
+      if (arg.type) {
+        m_os << " ";
+        print(**arg.type);
+      }
+
+      if (&arg < &fn.args().back())
+        m_os << ", ";
+    }
+
+    m_os << ") ";
+    print(*fn.type());
+
+    if (fn.context()) {
+      m_os << " : ";
+      print(**fn.context());
+    }
+
+    m_os << " = ";
+  }
+
+  void SourcePrinter::visit(const IntLit &lit, size_t) {
+    m_os << lit.value();
+  }
+
+  void SourcePrinter::visit(const Var &var, size_t) {
+    m_os << *var.name();
+  }
+
+  void SourcePrinter::visit(const FunCal &call, size_t i) {
+    size_t n = call.operands();
+
+    if (i == 0)
+      m_os << *call.name() << "(";
+    else if (i < n)
+      m_os << ", ";
+
+    if (i == n)
+      m_os << ")";
+  }
+
+  void SourcePrinter::visit(const BinOp &op, size_t i) {
+    // operands that are operations themselves get parens, so what is
+    // printed parses back to the same tree
+    auto nested = [&](size_t k) {
+      return dynamic_cast<const BinOp *>(&op.operand(k)) != nullptr;
+    };
+
+    switch (i) {
+    case 0:
+      if (nested(0))
+        m_os << "(";
+      break;
+    case 1:
+      if (nested(0))
+        m_os << ")";
+      m_os << " " << op.op() << " ";
+      if (nested(1))
+        m_os << "(";
+      break;
+    case 2:
+      if (nested(1))
+        m_os << ")";
+      break;
+    }
+  }
+
+
+  // S-expressions
+
+  void SExprPrinter::print(const Type &type) {
+    if (type.args().empty()) {
+      m_os << Symbols::str(type.symbol());
+      return;
+    }
+
+    m_os << "(" << Symbols::str(type.symbol());
+    for (auto arg : type.args()) {
+      m_os << " ";
+      print(*arg);
+    }
+    m_os << ")";
+  }
+
+  void SExprPrinter::statement(const TopLvl &stmnt) {
+    print(stmnt);
+    m_os << "\n";
+  }
+
+  template<class Fn>
+  void SExprPrinter::header(const char *what, const Fn &fn) {
+    m_os << "(" << what << " " << *fn.name() << " (";
+
+    for (auto &arg : fn.args()) {
+      if (&arg > &fn.args().front())
+        m_os << " ";
+
+      m_os << "(";
+      if (auto name = name_of(arg))
+        m_os << *name;
+      else
+        m_os << "nil";
+
+      m_os << " ";
+      if (auto type = type_of(arg))
+        print(*type);
+      else
+        m_os << "nil";
+      m_os << ")";
+    }
+
+    m_os << ") ";
+    print(*fn.type());
+
+    m_os << " ";
+    if (fn.context())
+      print(**fn.context());
+    else
+      m_os << "nil";
+  }
+
+  void SExprPrinter::visit(const FunDec &fn) {
+    header("declare", fn);
+    m_os << ")";
+  }
+
+  void SExprPrinter::visit(const FunDef &fn, size_t i) {
+    if (i == 0) {
+      header("define", fn);
+      m_os << " ";
+    } else {
+      m_os << ")";
+    }
+  }
+
+  void SExprPrinter::visit(const IntLit &lit, size_t) {
+    m_os << lit.value();
+  }
+
+  void SExprPrinter::visit(const Var &var, size_t) {
+    m_os << *var.name();
+  }
+
+  void SExprPrinter::visit(const FunCal &call, size_t i) {
+    if (i == 0)
+      m_os << "(call " << *call.name();
+
+    if (i < call.operands())
+      m_os << " ";
+    else
+      m_os << ")";
+  }
+
+  void SExprPrinter::visit(const BinOp &op, size_t i) {
+    switch (i) {
+    case 0: m_os << "(" << op.op() << " "; break;
+    case 1: m_os << " ";                   break;
+    case 2: m_os << ")";                   break;
+    }
+  }
+
+
+  // JSON
+
+  void JsonPrinter::string(Parser::Symbol name) {
+    m_os << '"';
+
+    for (char c : Symbols::str(name)) {
+      if (c == '"' || c == '\\') {
+        m_os << '\\' << c;
+      } else if ((unsigned char)c < 0x20) {
+        char esc[8];
+        std::snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)c);
+        m_os << esc;
+      } else {
+        m_os << c;
+      }
+    }
+
+    m_os << '"';
+  }
+
+  void JsonPrinter::print(const Type &type) {
+    m_os << "{\"name\":";
+    string(type.symbol());
+    m_os << ",\"args\":[";
+
+    for (auto &arg : type.args()) {
+      if (&arg > &type.args().front())
+        m_os << ",";
+      print(*arg);
+    }
+
+    m_os << "]}";
+  }
+
+  void JsonPrinter::begin() {
+    m_statements = 0;
+    m_os << "[";
+  }
+
+  void JsonPrinter::statement(const TopLvl &stmnt) {
+    m_os << (m_statements++ > 0 ? ",\n" : "\n");
+    print(stmnt);
+  }
+
+  void JsonPrinter::end() {
+    m_os << (m_statements > 0 ? "\n]\n" : "]\n");
+  }
+
+  template<class Fn>
+  void JsonPrinter::header(const char *kind, const Fn &fn) {
+    m_os << "{\"kind\":\"" << kind << "\",\"name\":";
+    string(fn.name()->symbol());
+    m_os << ",\"args\":[";
+
+    for (auto &arg : fn.args()) {
+      if (&arg > &fn.args().front())
+        m_os << ",";
+
+      m_os << "{\"name\":";
+      if (auto name = name_of(arg))
+        string(name->symbol());
+      else
+        m_os << "null";
+
+      m_os << ",\"type\":";
+      if (auto type = type_of(arg))
+        print(*type);
+      else
+        m_os << "null";
+      m_os << "}";
+    }
+
+    m_os << "],\"type\":";
+    print(*fn.type());
+
+    m_os << ",\"context\":";
+    if (fn.context())
+      print(**fn.context());
+    else
+      m_os << "null";
+  }
+
+  void JsonPrinter::visit(const FunDec &fn) {
+    header("FunDec", fn);
+    m_os << "}";
+  }
+
+  void JsonPrinter::visit(const FunDef &fn, size_t i) {
+    if (i == 0) {
+      header("FunDef", fn);
+      m_os << ",\"body\":";
+    } else {
+      m_os << "}";
+    }
+  }
+
+  void JsonPrinter::visit(const IntLit &lit, size_t) {
+    m_os << "{\"kind\":\"IntLit\",\"value\":" << lit.value() << "}";
+  }
+
+  void JsonPrinter::visit(const Var &var, size_t) {
+    m_os << "{\"kind\":\"Var\",\"name\":";
+    string(var.name()->symbol());
+    m_os << "}";
+  }
+
+  void JsonPrinter::visit(const FunCal &call, size_t i) {
+    if (i == 0) {
+      m_os << "{\"kind\":\"FunCal\",\"name\":";
+      string(call.name()->symbol());
+      m_os << ",\"args\":[";
+    } else if (i < call.operands()) {
+      m_os << ",";
+    }
+
+    if (i == call.operands())
+      m_os << "]}";
+  }
+
+  void JsonPrinter::visit(const BinOp &op, size_t i) {
+    switch (i) {
+    case 0: m_os << "{\"kind\":\"BinOp\",\"op\":\"" << op.op() << "\",\"lhs\":";
+      break;
+    case 1: m_os << ",\"rhs\":"; break;
+    case 2: m_os << "}";         break;
+    }
+  }
+}
@@ -0,0 +1,127 @@
+#ifndef FYRE_PRINTER_H
+#define FYRE_PRINTER_H
+
+#include <ostream>
+#include <cstddef>
+
+#include "AST.h"
+
+namespace Fyre {
+  /// Writes an AST straight to an ostream, in a format of a subclass
+
+  /// The nodes call back visit() for their kind (see ANode's accept()),
+  /// an expression once before each of its operands and once after the
+  /// last, with `i` saying which, so a format only writes what goes
+  /// between them. Nothing is built up on the side, printing is linear
+  /// in the size of the output, and expressions are walked with a stack
+  /// of the printer's own however deep they nest.
+  class Printer {
+  public:
+    Printer(std::ostream &os) : m_os(os) {}
+    virtual ~Printer() = default;
+
+    /// The whole module: begin(), statement() for each, end()
+    void print(const Module &module);
+    /// A statement on its own
+    void print(const TopLvl &stmnt) { stmnt.accept(*this); }
+    /// An expression on its own
+    void print(const Expr &expr);
+    virtual void print(const Type &type) = 0;
+
+    /// What surrounds the statements of a module, a stream of them can
+    /// be printed with these
+    virtual void begin() {}
+    virtual void statement(const TopLvl &stmnt) = 0;
+    virtual void end() {}
+
+    virtual void visit(const FunDec &fn) = 0;
+    /// i is 0 before the body, 1 after
+    virtual void visit(const FunDef &fn, size_t i) = 0;
+
+    virtual void visit(const IntLit &lit, size_t i) = 0;
+    virtual void visit(const Var &var, size_t i) = 0;
+    virtual void visit(const FunCal &call, size_t i) = 0;
+    virtual void visit(const BinOp &op, size_t i) = 0;
+
+  protected:
+    std::ostream &m_os;
+  };
+
+  /// Fyre source, which parses back to the same AST
+  class SourcePrinter : public Printer {
+  public:
+    using Printer::Printer;
+    using Printer::print;
+
+    void print(const Type &type) override;
+    void statement(const TopLvl &stmnt) override;
+
+    void visit(const FunDec &fn) override;
+    void visit(const FunDef &fn, size_t i) override;
+
+    void visit(const IntLit &lit, size_t i) override;
+    void visit(const Var &var, size_t i) override;
+    void visit(const FunCal &call, size_t i) override;
+    void visit(const BinOp &op, size_t i) override;
+  };
+
+  /// S-expressions, a statement per line
+
+  /// `(declare name args type context)` and `(define name args type
+  /// context body)`, each argument a `(name type)` pair with nil for a
+  /// missing part. Types are `Name` or `(Name args...)`, calls
+  /// `(call name args...)` and operations `(op lhs rhs)`.
+  class SExprPrinter : public Printer {
+  public:
+    using Printer::Printer;
+    using Printer::print;
+
+    void print(const Type &type) override;
+    void statement(const TopLvl &stmnt) override;
+
+    void visit(const FunDec &fn) override;
+    void visit(const FunDef &fn, size_t i) override;
+
+    void visit(const IntLit &lit, size_t i) override;
+    void visit(const Var &var, size_t i) override;
+    void visit(const FunCal &call, size_t i) override;
+    void visit(const BinOp &op, size_t i) override;
+
+  private:
+    template<class Fn>
+    void header(const char *what, const Fn &fn);
+  };
+
+  /// JSON, a module is an array of statements, each on a line
+
+  /// Every node is an object with its "kind" and its parts by name,
+  /// missing ones null. Types are {"name", "args"} objects.
+  class JsonPrinter : public Printer {
+  public:
+    using Printer::Printer;
+    using Printer::print;
+
+    void print(const Type &type) override;
+
+    void begin() override;
+    void statement(const TopLvl &stmnt) override;
+    void end() override;
+
+    void visit(const FunDec &fn) override;
+    void visit(const FunDef &fn, size_t i) override;
+
+    void visit(const IntLit &lit, size_t i) override;
+    void visit(const Var &var, size_t i) override;
+    void visit(const FunCal &call, size_t i) override;
+    void visit(const BinOp &op, size_t i) override;
+
+  private:
+    template<class Fn>
+    void header(const char *kind, const Fn &fn);
+    void string(Parser::Symbol name);
+
+    size_t m_statements = 0;
+  };
+}
+
+#endif
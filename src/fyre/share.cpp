@@ -0,0 +1,134 @@
+#include "share.h"
+
+#include <algorithm>
+#include <memory>
+
+#include <parser/small_vector.h>
+
+namespace Fyre {
+  // The table
+
+  uint64_t ExprTable::hash_of(Shape shape, uint64_t payload,
+                              const ExprPtr *operands, size_t n) {
+    auto mix = [](uint64_t h, uint64_t v) {
+      h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+      return h * 0xff51afd7ed558ccdULL;
+    };
+
+    uint64_t h = mix((uint64_t)shape, payload);
+    for (size_t i = 0; i < n; i++)
+      h = mix(h, (uintptr_t)operands[i]);
+
+    return h ^ (h >> 32);
+  }
+
+  ExprPtr ExprTable::find(uint64_t hash, Shape shape, uint64_t payload,
+                          const ExprPtr *operands, size_t n) const {
+    if (m_slots.empty())
+      return nullptr;
+
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = hash & mask; m_slots[i].node != nullptr;
+         i = (i + 1) & mask) {
+      const Slot &s = m_slots[i];
+      if (s.hash != hash || s.shape != shape || s.payload != payload ||
+          s.node->operands() != n)
+        continue;
+
+      bool same = true;
+      for (size_t k = 0; k < n && same; k++)
+        same = &s.node->operand(k) == operands[k];
+
+      if (same)
+        return s.node;
+    }
+
+    return nullptr;
+  }
+
+  void ExprTable::insert(uint64_t hash, Shape shape, uint64_t payload,
+                         ExprPtr node) {
+    if (2 * (m_count + 1) > m_slots.size()) {
+      std::vector<Slot> old(std::max<size_t>(64, 2 * m_slots.size()));
+      old.swap(m_slots);
+
+      m_count = 0;
+      for (auto &s : old)
+        if (s.node != nullptr)
+          insert(s.hash, s.shape, s.payload, s.node);
+    }
+
+    size_t mask = m_slots.size() - 1;
+    size_t i = hash & mask;
+    while (m_slots[i].node != nullptr)
+      i = (i + 1) & mask;
+
+    m_slots[i] = { hash, payload, node, shape };
+    m_count++;
+  }
+
+
+  // Interning the nodes
+
+  ExprPtr Expr::share(ExprTable &table) const {
+    return post_order<ExprPtr>([&](const Expr &e, const ExprPtr *operands) {
+      return e.share_node(table, operands);
+    });
+  }
+
+  ExprPtr IntLit::share_node(ExprTable &table, const ExprPtr *) const {
+    return table.intern(*this, ExprTable::Shape::Lit, m_val, nullptr, [&] {
+      return table.arena().make<IntLit>(m_val);
+    });
+  }
+
+  ExprPtr Var::share_node(ExprTable &table, const ExprPtr *) const {
+    return table.intern(*this, ExprTable::Shape::Var, m_name->symbol(),
+                        nullptr, [&] {
+      return table.arena().make<Var>(m_name);
+    });
+  }
+
+  ExprPtr FunCal::share_node(ExprTable &table,
+                             const ExprPtr *operands) const {
+    return table.intern(*this, ExprTable::Shape::Call, m_name->symbol(),
+                        operands, [&] {
+      Parser::SmallVector<ExprPtr, 4> args;
+      for (size_t i = 0; i < m_args.size(); i++)
+        args.push_back(operands[i]);
+
+      return table.arena().make<FunCal>(m_name, table.arena().copy(args));
+    });
+  }
+
+  ExprPtr BinOp::share_node(ExprTable &table,
+                            const ExprPtr *operands) const {
+    return table.intern(*this, ExprTable::Shape::Op, m_op, operands, [&] {
+      return table.arena().make<BinOp>(m_op, operands[0], operands[1]);
+    });
+  }
+
+
+  // Sharing a module
+
+  ModulePtr Module::share() const {
+    auto arena = std::make_shared<Parser::Arena>();
+    ExprTable table(*arena);
+
+    // only definitions have expressions
+    std::vector<TopLvlPtr> stmnts;
+    for (auto stmnt : m_statements) {
+      if (auto def = dynamic_cast<FunDefPtr>(stmnt))
+        stmnt = arena->make<FunDef>(def->name(), def->args(), def->type(),
+                                    def->context(),
+                                    def->expr()->share(table));
+      stmnts.push_back(stmnt);
+    }
+
+    Arenas arenas = m_arenas;
+    arenas.push_back(std::move(arena));
+
+    return std::make_shared<Module>(std::move(stmnts), m_spans, m_file,
+                                    std::move(arenas));
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef FYRE_SHARE_H
+#define FYRE_SHARE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "AST.h"
+
+namespace Fyre {
+  /// Expression nodes by their structure, one for each
+
+  /// A node is known by its shape, a payload saying which of that
+  /// shape it is (the value, name or operator) and the nodes of its
+  /// operands, which are already in the table, so equal subtrees come
+  /// out as the same node. Each node's share_node() tells intern() its
+  /// parts. The nodes are the table's own, made in its arena, so the
+  /// expressions interned are never changed.
+  class ExprTable {
+  public:
+    enum class Shape : uint8_t { Lit, Var, Call, Op };
+
+    ExprTable(Parser::Arena &arena) : m_arena(arena), m_count(0) {}
+
+    /// Where nodes made for the table go
+    Parser::Arena &arena() { return m_arena; }
+
+    /// The node of the table equal to `node` with `operands`, what
+    /// `make()` gives for the first
+    template<class Make>
+    ExprPtr intern(const Expr &node, Shape shape, uint64_t payload,
+                   const ExprPtr *operands, Make make) {
+      size_t n = node.operands();
+      uint64_t hash = hash_of(shape, payload, operands, n);
+
+      if (ExprPtr found = find(hash, shape, payload, operands, n)) {
+        found->m_shared = true;
+        return found;
+      }
+
+      ExprPtr e = make();
+      insert(hash, shape, payload, e);
+      return e;
+    }
+
+    /// How many different nodes there are
+    size_t size() const { return m_count; }
+
+  private:
+    struct Slot {
+      uint64_t hash;
+      uint64_t payload;
+      ExprPtr node;
+      Shape shape;
+    };
+
+    static uint64_t hash_of(Shape shape, uint64_t payload,
+                            const ExprPtr *operands, size_t n);
+
+    ExprPtr find(uint64_t hash, Shape shape, uint64_t payload,
+                 const ExprPtr *operands, size_t n) const;
+    void insert(uint64_t hash, Shape shape, uint64_t payload, ExprPtr node);
+
+    Parser::Arena &m_arena;
+    // open addressing, a power of two in size and at most half full
+    std::vector<Slot> m_slots;
+    size_t m_count;
+  };
+}
+
+#endif
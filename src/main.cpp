@@ -1,13 +1,22 @@
 
 #include <iostream>
 #include <sstream>
+#include <memory>
+#include <cstdlib>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 
 #include "fyre/AST.h"
 #include "fyre/parser.h"
 #include "fyre/context.h"
+#include "fyre/compile.h"
+#include "fyre/flat.h"
+#include "fyre/cache.h"
+#include "fyre/printer.h"
 
 #include "parser/parser.h"
+#include "parser/lexer.h"
 #include "parser/exceptions.h"
 
 using std::cout;
@@ -17,10 +26,10 @@ using std::endl;
 void test_loc() {
   std::stringstream ss("012345\n789012\n");
   Parser::IParseStream in(ss);
-  Parser::Location l;
+  Parser::Position l;
 
   // Initial
-  l = in.get_loc();
+  l = Parser::Files::resolve(in.get_loc());
   assert(l.line == 1);
   assert(l.chr  == 0);
   assert(l.total_chr == 0);
@@ -29,7 +38,7 @@ void test_loc() {
   // cout << (char)in.get() << endl;
 
   // Forward
-  l = in.get_loc();
+  l = Parser::Files::resolve(in.get_loc());
   assert(l.line == 1);
   assert(l.chr  == 1);
   assert(l.total_chr == 1);
@@ -39,7 +48,7 @@ void test_loc() {
     in.get();
 
   // Forward
-  l = in.get_loc();
+  l = Parser::Files::resolve(in.get_loc());
   assert(l.line == 1);
   assert(l.chr  == 5);
   assert(l.total_chr == 5);
@@ -47,7 +56,7 @@ void test_loc() {
   in.seekg(pos);
 
   // Reverse
-  l = in.get_loc();
+  l = Parser::Files::resolve(in.get_loc());
   assert(l.line == 1);
   assert(l.chr  == 1);
   assert(l.total_chr == 1);
@@ -57,7 +66,7 @@ void test_loc() {
     in.get();
 
   // Forward
-  l = in.get_loc();
+  l = Parser::Files::resolve(in.get_loc());
   assert(l.line == 2);
   assert(l.chr  == 3);
   assert(l.total_chr == 10);
@@ -65,7 +74,7 @@ void test_loc() {
   in.seekg(pos);
 
   // Reverse
-  l = in.get_loc();
+  l = Parser::Files::resolve(in.get_loc());
   assert(l.line == 1);
   assert(l.chr  == 1);
   assert(l.total_chr == 1);
@@ -76,26 +85,188 @@ int main(int argc, char **argv) {
 
   // test_loc();
 
-  Parser::IParseStream in(std::cin);
+  // lets cin buffer on its own, so the parser can read it in blocks
+  std::ios::sync_with_stdio(false);
+
+  // fyrec [-j jobs] [-q depth] [-f] [-n] [-c] [-d fyre|sexp|json]
+  //       [-r rewinds] [-b bytes] [-t ms] [-s] [file]
+  unsigned int jobs = 1;
+  size_t queue = 0;
+  Parser::Budget budget;
+  long timeout = 0;
+  bool stats = false;
+  bool flat = false;
+  bool cache = true;
+  bool share = false;
+  std::string format = "fyre";
+  const char *file = NULL;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "-j" && i + 1 < argc)
+      jobs = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "-q" && i + 1 < argc)
+      queue = std::strtoull(argv[++i], NULL, 10);
+    else if (arg == "-r" && i + 1 < argc)
+      budget.rewinds = std::strtoull(argv[++i], NULL, 10);
+    else if (arg == "-b" && i + 1 < argc)
+      budget.rescanned = std::strtoull(argv[++i], NULL, 10);
+    else if (arg == "-t" && i + 1 < argc)
+      timeout = std::atol(argv[++i]);
+    else if (arg == "-s")
+      stats = true;
+    else if (arg == "-f")
+      flat = true;
+    else if (arg == "-n")
+      cache = false;
+    else if (arg == "-c")
+      share = true;
+    else if (arg == "-d" && i + 1 < argc)
+      format = argv[++i];
+    else
+      file = argv[i];
+  }
+
+  // the module is dumped in this format before its IR
+  std::unique_ptr<Fyre::Printer> printer;
+  if (format == "fyre")
+    printer = std::make_unique<Fyre::SourcePrinter>(std::cout);
+  else if (format == "sexp")
+    printer = std::make_unique<Fyre::SExprPrinter>(std::cout);
+  else if (format == "json")
+    printer = std::make_unique<Fyre::JsonPrinter>(std::cout);
+  else {
+    std::cerr << "Unknown format: " << format << std::endl;
+    return 1;
+  }
+
+  // read from the given file (mmapped) or fall back to stdin
+  std::unique_ptr<Parser::IParseStream> in_ptr;
+  try {
+    if (file != NULL)
+      in_ptr = std::make_unique<Parser::IParseStream>(std::string(file));
+    else
+      in_ptr = std::make_unique<Parser::IParseStream>(std::cin);
+
+  } catch (Parser::FileError &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  Parser::IParseStream &in = *in_ptr;
   // llvm::LLVMContext lctx;
   // llvm::IRBuilder<> builder(lctx);
   // llvm::Module module("fyrec-jit", lctx);
   // Fyre::Context ctx(lctx, builder, module);
 
-  Fyre::ModulePtr module;
+  Parser::ParseCursor cur = in.cursor();
+  Parser::TokenCursor toks(cur);
+
+  if (timeout > 0)
+    budget.deadline = std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(timeout);
+  cur.set_budget(budget);
+  toks.set_budget(budget);
+
+  // a file parsed before with the same text is loaded from its cache
+  // (mmapped) without parsing, unless it's dumped as something other
+  // than Fyre, which takes the tree. Otherwise its flat form is built
+  // along the way and cached once the module compiles.
+  std::string cache_path;
+  uint64_t cache_key = 0;
+  std::unique_ptr<Fyre::FlatModule> flat_module;
+  bool cached = false;
+  if (cache && file != NULL) {
+    cache_path = Fyre::Cache::path(file);
+    // the flat form of a shared module generates different IR
+    cache_key = Fyre::Cache::key(in.lrdbuf()->mapping(), share);
+    if (format == "fyre")
+      flat_module = Fyre::Cache::load(cache_path, cache_key);
+    cached = flat_module != nullptr;
+  }
+
+  // with one job, each statement is compiled as soon as it's parsed,
+  // otherwise the whole module is parsed (in parallel) first, maybe has
+  // its equal subexpressions shared and is maybe laid out flat before
+  // it's compiled
+  std::unique_ptr<Fyre::ContextRoot> ctx;
   try {
-    module = in.one_of<Fyre::Module>();
+    if (cached) {
+      std::cout << *flat_module << "\n" << std::endl;
+      ctx = flat_module->codegen("main");
+
+    } else if (flat) {
+      {
+        Fyre::ModulePtr module;
+        if (jobs > 1)
+          module = Fyre::Module::parse_parallel(cur, jobs);
+        else if (auto r = toks.one_of<Fyre::Module>())
+          module = *r;
+        else
+          throw toks.error();
+
+        if (share)
+          module = module->share();
+        flat_module = std::make_unique<Fyre::FlatModule>(*module);
+        if (format != "fyre")
+          printer->print(*module);
+      }
+
+      if (format == "fyre")
+        std::cout << *flat_module;
+      std::cout << "\n" << std::endl;
+      ctx = flat_module->codegen("main");
+
+    } else if (jobs > 1 || share) {
+      Fyre::ModulePtr module;
+      if (jobs > 1)
+        module = Fyre::Module::parse_parallel(cur, jobs);
+      else if (auto r = toks.one_of<Fyre::Module>())
+        module = *r;
+      else
+        throw toks.error();
+
+      if (share)
+        module = module->share();
+      if (!cache_path.empty())
+        flat_module = std::make_unique<Fyre::FlatModule>(*module);
+
+      printer->print(*module);
+      std::cout << "\n" << std::endl;
+      ctx = module->codegen("main");
+
+    } else {
+      ctx = std::make_unique<Fyre::ContextRoot>("main");
+      if (!cache_path.empty())
+        flat_module = std::make_unique<Fyre::FlatModule>();
+
+      Fyre::FlatModule *to_cache = flat_module.get();
+      printer->begin();
+      Fyre::compile_stream(toks, *ctx, [&](const Fyre::TopLvl &s) {
+        printer->statement(s);
+        if (to_cache)
+          s.flatten(*to_cache);
+      }, queue);
+      printer->end();
+
+      std::cout << "\n" << std::endl;
+    }
+
+    if (!cached && !cache_path.empty())
+      Fyre::Cache::store(cache_path, cache_key, *flat_module);
 
   } catch (Parser::Error &e) {
+    std::cout << std::flush;
     std::cerr << "Parser error: " << e.what() << std::endl;
+    return 1;
   }
 
-  std::cout << module
-            << "\n"
-            << std::endl;
-
+  if (stats) {
+    auto &s = jobs > 1 ? cur.stats() : toks.stats();
+    std::cerr << "parse: " << s.rewinds << " rewinds, "
+              << s.rescanned << " bytes re-scanned" << std::endl;
+  }
 
-  module->codegen("main")->module().print(llvm::outs(), nullptr);
+  ctx->module().print(llvm::outs(), nullptr);
   std::cout << std::endl;
 
 
@@ -0,0 +1,37 @@
+#include "arena.h"
+
+#include <algorithm>
+
+namespace Parser {
+
+  namespace {
+    // what each block starts with
+    struct Header {
+      char *prev;
+    };
+  }
+
+  Arena::~Arena() {
+    while (m_last) {
+      char *prev = reinterpret_cast<Header *>(m_last)->prev;
+      ::operator delete(m_last);
+      m_last = prev;
+    }
+  }
+
+  char *Arena::grow(size_t size, size_t align) {
+    size_t need = sizeof(Header) + size + align;
+    size_t block = std::max(m_next_size, need);
+
+    char *mem = static_cast<char *>(::operator new(block));
+    reinterpret_cast<Header *>(mem)->prev = m_last;
+    m_last = mem;
+
+    m_cur = mem + sizeof(Header);
+    m_end = mem + block;
+    m_next_size = std::min(m_next_size * 2, max_block);
+
+    return align_up(m_cur, align);
+  }
+
+}
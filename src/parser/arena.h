@@ -0,0 +1,115 @@
+#ifndef PARSER_ARENA_H
+#define PARSER_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace Parser {
+
+  /// A run of T that lives in an Arena
+  template<class T>
+  class Slice {
+  public:
+    using value_type     = T;
+    using iterator       = T *;
+    using const_iterator = const T *;
+
+    Slice() : m_data(nullptr), m_size(0) {}
+    Slice(T *data, size_t size) : m_data(data), m_size(size) {}
+
+    iterator       begin()       { return m_data; }
+    iterator       end()         { return m_data + m_size; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end()   const { return m_data + m_size; }
+
+    size_t size()  const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+
+    T       &operator[](size_t i)       { return m_data[i]; }
+    const T &operator[](size_t i) const { return m_data[i]; }
+
+    const T &front() const { return m_data[0]; }
+    const T &back()  const { return m_data[m_size - 1]; }
+
+  private:
+    T *m_data;
+    size_t m_size;
+  };
+
+
+  /// Memory for values that all go at once
+
+  /// Allocating is bumping a pointer. Nothing is freed before the whole
+  /// Arena is, so only trivially destructible values can go in, and
+  /// they can point at each other freely. Blocks double in size as it
+  /// fills up, so an arena for a few values stays small.
+  class Arena {
+  public:
+    Arena() : m_cur(nullptr), m_end(nullptr), m_last(nullptr),
+              m_next_size(first_block) {}
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    void *allocate(size_t size, size_t align) {
+      char *p = align_up(m_cur, align);
+      if (m_cur == nullptr || p + size > m_end)
+        p = grow(size, align);
+
+      m_cur = p + size;
+      return p;
+    }
+
+    /// A T made from `args`, it lives as long as the arena
+    template<class T, class ...Args>
+    T *make(Args &&...args) {
+      static_assert(std::is_trivially_destructible_v<T>,
+                    "nothing in an Arena is ever destroyed");
+
+      return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    }
+
+    /// The elements of `elems` moved into the arena
+    template<class Elems>
+    auto copy(Elems &&elems) {
+      using T = typename std::decay_t<Elems>::value_type;
+      static_assert(std::is_trivially_destructible_v<T>,
+                    "nothing in an Arena is ever destroyed");
+
+      if (elems.size() == 0)
+        return Slice<T>();
+
+      T *data = static_cast<T *>(allocate(elems.size() * sizeof(T),
+                                          alignof(T)));
+      size_t n = 0;
+      for (auto &e : elems)
+        new (data + n++) T(std::move(e));
+
+      return Slice<T>(data, n);
+    }
+
+  private:
+    static constexpr size_t first_block = 1024;
+    static constexpr size_t max_block   = 1 << 20;
+
+    static char *align_up(char *p, size_t align) {
+      return (char *)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+    }
+
+    // start a new block with room for `size` bytes
+    char *grow(size_t size, size_t align);
+
+    char *m_cur;
+    char *m_end;
+    // blocks are chained through their first bytes, newest first
+    char *m_last;
+    size_t m_next_size;
+  };
+
+}
+
+#endif
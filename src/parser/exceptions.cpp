@@ -19,44 +19,68 @@ namespace Parser {
   }
 
   Error::Error(std::optional<Location>   loc,
-                           std::optional<std::string> msg) : m_loc(loc) {
+                           std::optional<std::string> msg)
+    : m_msg(std::move(msg)), m_loc(loc) {}
+
+  const char *Error::what() const throw() {
+    if (m_what.empty())
+      m_what = format();
+    return m_what.c_str();
+  }
+
+  void Error::relocate(uint32_t file) {
+    if (m_loc)
+      m_loc->file = file;
+    m_what.clear();
+  }
+
+  std::string Error::format() const {
     std::ostringstream r;
     r << "error parsing input in ";
 
     // if location is known
     if (m_loc) {
-      r << m_loc->file
+      Position pos = Files::resolve(*m_loc);
+      r << pos.file
         << " at "
-        << m_loc->line << ":" << m_loc->chr;
+        << pos.line << ":" << pos.chr;
     } else {
       r << "unknown location";
     }
 
-    if (msg) {
-      r << " : \n" << indent(*msg);
+    if (m_msg) {
+      r << " : \n" << indent(*m_msg);
     }
 
-    m_msg = r.str();
+    return r.str();
   }
 
-  const char *Error::what() const throw() {
-    return m_msg.c_str();
-  }
+  UnexpectedEOF::UnexpectedEOF(std::optional<Location> loc) : Error(loc) {}
 
-  UnexpectedEOF::UnexpectedEOF(std::optional<Location> loc) {
-    m_loc = loc;
+  std::string UnexpectedEOF::format() const {
     std::ostringstream r;
     r << "Unexpected end of file";
 
     // if location is known
     if (m_loc) {
+      Position pos = Files::resolve(*m_loc);
       r << " in "
-        << m_loc->file
+        << pos.file
         << " at "
-        << m_loc->line << ":" << m_loc->chr;
+        << pos.line << ":" << pos.chr;
     }
 
-    m_msg = r.str();
+    return r.str();
+  }
+
+  BudgetExceeded::BudgetExceeded(Location loc, const std::string &what)
+    : Error(loc, "Gave up parsing after " + what) {}
+
+  FileError::FileError(const std::string &file, const std::string &reason)
+    : Error(std::nullopt, "error reading " + file + " : " + reason) {}
+
+  std::string FileError::format() const {
+    return *m_msg;
   }
 
 }
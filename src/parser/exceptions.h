@@ -8,6 +8,7 @@
 
 namespace Parser {
 
+  /// A parse error, the message is only put together by what()
   class Error : public std::exception {
   public:
     Error(std::optional<Location> loc = std::nullopt,
@@ -15,14 +16,40 @@ namespace Parser {
 
     virtual const char *what() const throw();
 
+    /// Resolve the location in `file` instead, another version of the
+    /// input it was found in
+    void relocate(uint32_t file);
+
   protected:
-    std::string m_msg;
+    virtual std::string format() const;
+
+    std::optional<std::string> m_msg;
     std::optional<Location> m_loc;
+
+  private:
+    mutable std::string m_what;
   };
 
   class UnexpectedEOF : public Error {
   public:
     UnexpectedEOF(std::optional<Location> loc = std::nullopt);
+
+  protected:
+    std::string format() const override;
+  };
+
+  /// Thrown when a parse goes over its Budget, see Combinators
+  class BudgetExceeded : public Error {
+  public:
+    BudgetExceeded(Location loc, const std::string &what);
+  };
+
+  class FileError : public Error {
+  public:
+    FileError(const std::string &file, const std::string &reason);
+
+  protected:
+    std::string format() const override;
   };
 
 }
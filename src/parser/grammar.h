@@ -0,0 +1,96 @@
+#ifndef PARSER_GRAMMAR_H
+#define PARSER_GRAMMAR_H
+
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include "parser.h"
+#include "result.h"
+
+// Grammar combinators
+
+// Each of these is a type with a static parse() template over cursors,
+// so they nest like any other parsable type and a whole rule such as
+// Enclosed<Char<lp>, SepBy<Arg, Char<comma>>, Char<rp>> is a single
+// inlinable function. Parts go through the cursor's one_of()/maybe_of()
+// so they backtrack and memoize as usual.
+
+namespace Parser {
+
+  /// One char from S (a Punct token, on a TokenCursor)
+  template<const CharSet &S>
+  struct Char {
+    template<class Cursor>
+    static Result<char> parse(Cursor &in) {
+      return in.one_of(S);
+    }
+  };
+
+
+  /// Any number of P separated by Sep, never fails
+
+  /// The values are collected into an Elems, a std::vector by default.
+  /// NOTE: accepts a trailing separator
+  template<class P, class Sep, class Elems = void>
+  struct SepBy {
+    template<class Cursor>
+    using ElemsOf = std::conditional_t<std::is_void_v<Elems>,
+                                       std::vector<ValueOf<P, Cursor>>,
+                                       Elems>;
+
+    template<class Cursor>
+    static Result<ElemsOf<Cursor>> parse(Cursor &in) {
+      ElemsOf<Cursor> r;
+
+      for (;;) {
+        auto e = in.template maybe_of<P>();
+        if (!e)
+          break;
+
+        r.push_back(std::move(*e));
+
+        if (!in.template maybe_of<Sep>())
+          break;
+      }
+
+      return r;
+    }
+  };
+
+
+  template<const CharSet &S>
+  struct First<Char<S>> {
+    static constexpr const CharSet &set = S;
+  };
+
+
+  /// P between L and R, giving the value of P
+  template<class L, class P, class R>
+  struct Enclosed {
+    template<class Cursor>
+    static Result<ValueOf<P, Cursor>> parse(Cursor &in) {
+      auto lhs = in.template one_of<L>();
+      if (!lhs)
+        return lhs.failure();
+
+      auto r = in.template one_of<P>();
+      if (!r)
+        return r.failure();
+
+      auto rhs = in.template one_of<R>();
+      if (!rhs)
+        return rhs.failure();
+
+      return std::move(*r);
+    }
+  };
+
+  template<class L, class P, class R>
+  struct First<Enclosed<L, P, R>> {
+    static constexpr const CharSet &set = First<L>::set;
+  };
+
+}
+
+#endif
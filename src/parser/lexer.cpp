@@ -0,0 +1,114 @@
+#include "lexer.h"
+#include "scan.h"
+#include "symbols.h"
+#include "exceptions.h"
+
+namespace Parser {
+  Lexer::Lexer(ParseCursor &in) : m_in(in), m_done(false) {}
+
+  bool Lexer::lex(std::vector<Token> &out, size_t n) {
+    if (m_done)
+      return false;
+
+    for (size_t i = 0; i < n; i++) {
+      m_in.skip_ws();
+
+      uint32_t off = m_in.tell();
+      int c = m_in.peek();
+
+      if (c == EOF) {
+        out.push_back({ Token::End, 0, off, 0, 0 });
+        m_done = true;
+        break;
+      }
+
+      if (word_head.contains(c)) {
+        auto w = *m_in.lexeme(word_head, word_tail);
+        out.push_back({ Token::Word, (char)c, off, (uint32_t)w.size(),
+                        Symbols::intern(w) });
+
+      } else if (digits.contains(c)) {
+        auto w = *m_in.lexeme(digits, digits);
+        out.push_back({ Token::Number, (char)c, off, (uint32_t)w.size(),
+                        Symbols::intern(w) });
+
+      } else {
+        m_in.get();
+        out.push_back({ Token::Punct, (char)c, off, 1, (uint32_t)c });
+      }
+    }
+
+    m_in.commit();
+
+    return !m_done;
+  }
+
+
+  TokenCursor::TokenCursor(ParseCursor &src)
+    : m_lexer(src), m_base(0), m_cur(0), m_file(src.get_loc().file) {}
+
+  void TokenCursor::fill() {
+    m_lexer.lex(m_toks, batch_size);
+  }
+
+  void TokenCursor::commit() {
+    forget();
+
+    // only drop the committed prefix once it is worth the move
+    if (m_cur < batch_size || m_cur < m_toks.size() - m_cur)
+      return;
+
+    m_toks.erase(m_toks.begin(), m_toks.begin() + m_cur);
+    m_base += m_cur;
+    m_cur = 0;
+  }
+
+  Failure TokenCursor::fail(std::string msg) {
+    m_failures.fail(tell(), get_loc(), std::move(msg));
+    return Failure();
+  }
+
+  Error TokenCursor::error() {
+    if (m_failures.empty())
+      return Error(get_loc());
+
+    size_t pos = tell();
+    seek(m_failures.pos());
+    Token t = peek();
+    seek(pos);
+
+    return Error(m_failures.loc(), m_failures.message(to_string(t)));
+  }
+
+  std::string TokenCursor::to_string(const Token &t) {
+    switch (t.kind) {
+    case Token::Word:
+    case Token::Number:
+      return "'" + std::string(Symbols::str(t.payload)) + "'";
+
+    case Token::Punct:
+      return std::string("'") + (char)t.payload + "'";
+
+    default:
+      return "end of file";
+    }
+  }
+
+  std::optional<Token> TokenCursor::maybe_of(Token::Kind kind,
+                                             const CharSet &first) {
+    // still noted as expected, so a later failure here can say so
+    auto r = one_of(kind, first);
+    if (!r)
+      return std::nullopt;
+
+    return *r;
+  }
+
+  std::optional<char> TokenCursor::maybe_of(const CharSet &set) {
+    auto r = one_of(set);
+    if (!r)
+      return std::nullopt;
+
+    return *r;
+  }
+}
@@ -0,0 +1,182 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <cstdint>
+#include <algorithm>
+
+#include "location.h"
+#include "parser.h"
+
+namespace Parser {
+
+  struct Token {
+    enum Kind : uint8_t {
+      Word,   // [A-Za-z_][A-Za-z0-9_]*
+      Number, // [0-9]+
+      Punct,  // any other single byte
+      End,
+    };
+
+    Kind     kind;
+    // the first byte of the text, 0 for End
+    char     head;
+    uint32_t offset;
+    uint32_t length;
+    // the Symbols id of the text for Word/Number, the byte for Punct
+    uint32_t payload;
+  };
+
+  /// Splits input into Tokens in a single pass, skipping whitespace
+  class Lexer {
+  public:
+    static constexpr CharSet word_head =
+      CharSet("word", CharSet('_', CharSet::range('a', 'z', "lower-case"),
+                                   CharSet::range('A', 'Z', "upper-case")));
+    static constexpr CharSet word_tail =
+      CharSet("word", CharSet(word_head, CharSet::range('0', '9', "digit")));
+    static constexpr CharSet digits = CharSet::range('0', '9', "digit");
+
+    Lexer(ParseCursor &in);
+
+    /// Lex up to n more tokens onto `out`, false once End has been lexed
+
+    /// The input is committed after every batch, all a token needs
+    /// afterwards is its payload.
+    bool lex(std::vector<Token> &out, size_t n);
+
+  private:
+    ParseCursor &m_in;
+    bool m_done;
+  };
+
+  /// A position in a window of Tokens, lexed on demand
+
+  /// Backtracking rewinds a token index, the bytes are only ever looked
+  /// at once, by the Lexer.
+  class TokenCursor : public Combinators<TokenCursor> {
+  public:
+    /// How many tokens to lex whenever the window runs out
+    static constexpr size_t batch_size = 1024;
+
+    TokenCursor(ParseCursor &src);
+
+    Token peek() {
+      if (m_cur == m_toks.size())
+        fill();
+      return m_toks[m_cur];
+    }
+
+    Token get() {
+      Token t = peek();
+      if (t.kind != Token::End)
+        m_cur++;
+      return t;
+    }
+
+    bool eof() { return peek().kind == Token::End; }
+
+    /// Absolute index of the current token
+    size_t tell() const { return m_base + m_cur; }
+    /// Rewind (or skip) to an index previously returned by tell()
+    void seek(size_t pos) { m_cur = pos - m_base; }
+    /// How many bytes the tokens from `pos` to the current one span
+    size_t bytes_since(size_t pos) const {
+      size_t from = pos - m_base;
+      if (from >= m_cur)
+        return 0;
+
+      const Token &last = m_toks[m_cur - 1];
+      return last.offset + last.length - m_toks[from].offset;
+    }
+
+    Location get_loc() { return { peek().offset, m_file }; }
+
+    /// Where the last token taken ends
+    uint32_t end_offset() const {
+      if (m_cur == 0)
+        return m_toks.empty() ? 0 : m_toks[0].offset;
+
+      const Token &last = m_toks[m_cur - 1];
+      return last.offset + last.length;
+    }
+
+    /// Where the farthest token looked at since the last commit ends,
+    /// whether it was taken or not
+    uint32_t reach() const {
+      uint32_t r = end_offset();
+      if (failures().empty())
+        return r;
+
+      const Token &t = m_toks[failures().pos() - m_base];
+      return std::max(r, t.offset + t.length);
+    }
+
+    uint32_t file() const { return m_file; }
+
+    /// The first byte of the current token, what ParserSets dispatch on
+    int lookahead() {
+      Token t = peek();
+      return t.kind == Token::End ? EOF : (unsigned char)t.head;
+    }
+
+    /// Forbid seeking before the current token and let the window drop
+    /// everything before it
+    void commit();
+
+    using Combinators<TokenCursor>::one_of;
+    using Combinators<TokenCursor>::maybe_of;
+
+    /// A Word/Number token whose text starts with a char from `first`
+    Result<Token> one_of(Token::Kind kind, const CharSet &first) {
+      Token t = peek();
+      if (matches(t, kind, first))
+        return get();
+
+      m_failures.expect(tell(), { t.offset, m_file },
+                        kind == Token::Word ? Failures::Word
+                                            : Failures::Number,
+                        first);
+      return Failure();
+    }
+    std::optional<Token> maybe_of(Token::Kind kind, const CharSet &first);
+
+    /// A Punct token from `set`
+    Result<char> one_of(const CharSet &set) {
+      Token t = peek();
+      if (t.kind == Token::Punct && set.contains(t.payload))
+        return (char)get().payload;
+
+      m_failures.expect(tell(), { t.offset, m_file }, Failures::Char, set);
+      return Failure();
+    }
+    std::optional<char> maybe_of(const CharSet &set);
+
+    /// Fail here for a reason other than what comes next
+    Failure fail(std::string msg);
+    /// The Error for the farthest failure since the last commit
+    Error error();
+
+    static std::string to_string(const Token &);
+
+  private:
+    void fill();
+
+    static bool matches(const Token &t, Token::Kind kind,
+                        const CharSet &first) {
+      return t.kind == kind && first.contains(t.head);
+    }
+
+    Lexer m_lexer;
+    std::vector<Token> m_toks;
+    // absolute index of m_toks[0]
+    size_t m_base;
+    size_t m_cur;
+    uint32_t m_file;
+  };
+
+}
+
+#endif
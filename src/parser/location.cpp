@@ -0,0 +1,79 @@
+#include "location.h"
+
+#include <set>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+namespace Parser {
+  namespace Files {
+    namespace {
+      struct Entry {
+        const std::string *name;
+
+        // offsets of the first byte of every line, line_starts[0] == 0
+        std::vector<uint32_t> line_starts;
+        // how far the input has been indexed
+        size_t indexed;
+      };
+
+      std::set<std::string> names;
+      // deque so entries don't move around as files are added
+      std::deque<Entry> entries;
+
+      std::mutex lock;
+    }
+
+    uint32_t add(const std::string &name) {
+      std::lock_guard<std::mutex> guard(lock);
+
+      const std::string *n = &*names.insert(name).first;
+
+      entries.push_back({ n, { 0 }, 0 });
+      return entries.size() - 1;
+    }
+
+    const std::string &name(uint32_t file) {
+      std::lock_guard<std::mutex> guard(lock);
+
+      return *entries.at(file).name;
+    }
+
+    void index(uint32_t file, size_t offset, const char *beg, const char *end) {
+      std::lock_guard<std::mutex> guard(lock);
+
+      Entry &e = entries.at(file);
+
+      if (offset + (end - beg) <= e.indexed)
+        return;
+
+      if (offset < e.indexed) {
+        beg += e.indexed - offset;
+        offset = e.indexed;
+      }
+
+      const char *c = beg;
+      while ((c = (const char *)std::memchr(c, '\n', end - c)) != NULL) {
+        c++;
+        e.line_starts.push_back(offset + (c - beg));
+      }
+
+      e.indexed = offset + (end - beg);
+    }
+
+    Position resolve(Location loc) {
+      std::lock_guard<std::mutex> guard(lock);
+
+      Entry &e = entries.at(loc.file);
+
+      // first line starting after loc, the one before it holds loc
+      auto it = std::upper_bound(e.line_starts.begin(), e.line_starts.end(),
+                                 loc.offset);
+      unsigned int line = it - e.line_starts.begin();
+
+      return { *e.name, line, loc.offset - *(it - 1), loc.offset };
+    }
+  }
+}
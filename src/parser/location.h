@@ -2,16 +2,45 @@
 #define LOCATION_H
 
 #include <string>
+#include <cstdint>
+#include <cstddef>
 
 namespace Parser {
 
+  /// A position in some input
+
+  /// Only the byte offset and the id of the input in the file table
+  /// are stored, line and column are worked out by Files::resolve when
+  /// a diagnostic actually needs them.
+  typedef struct {
+    uint32_t offset;
+    uint32_t file;
+  } Location;
+
+  /// A Location resolved to something human readable
   typedef struct {
     std::string file;
 
     unsigned int line;
     unsigned int chr;
     unsigned int total_chr;
-  } Location;
+  } Position;
+
+  /// The table of all inputs and their line-start indices
+  namespace Files {
+    /// Register a new input, names are interned but every call gets
+    /// its own id (and line index)
+    uint32_t add(const std::string &name);
+
+    const std::string &name(uint32_t file);
+
+    /// Index the line starts in [beg, end), which sit at `offset` in
+    /// the input. Input has to be fed in order, bytes that were already
+    /// indexed are skipped.
+    void index(uint32_t file, size_t offset, const char *beg, const char *end);
+
+    Position resolve(Location loc);
+  }
 
 }
 
@@ -1,80 +1,89 @@
 // #include "AST.h"
 #include "exceptions.h"
 #include "parser.h"
+#include "scan.h"
 
 #include <regex>
+#include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cstring>
 #include <string>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 namespace Parser {
   LocStreamBuf::LocStreamBuf(std::streambuf *sb,
-                             std::string filename) : m_sb(sb) {
+                             std::string filename)
+    : m_sb(sb), m_file(Files::add(filename)),
+      m_base(0), m_commit(0), m_map(NULL), m_map_size(0) {
     m_buf = std::vector<char>();
-    m_loc = { filename, 1, 0, 0 };
+  }
+
+  LocStreamBuf::LocStreamBuf(const std::string &filename)
+    : m_sb(NULL), m_file(Files::add(filename)),
+      m_base(0), m_commit(0), m_map(NULL), m_map_size(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw FileError(filename, std::strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+      int err = errno;
+      close(fd);
+      throw FileError(filename, std::strerror(err));
+    }
+
+    // mmap refuses empty mappings, an empty file is just an empty get area
+    if (st.st_size > 0) {
+      void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        throw FileError(filename, std::strerror(err));
+      }
+
+      madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+      m_map = (char *)map;
+      m_map_size = st.st_size;
+    }
+    close(fd);
+
+    // the whole source is the get area, underflow only ever hits EOF
+    setg(m_map, m_map, m_map + m_map_size);
+    Files::index(m_file, 0, m_map, m_map + m_map_size);
   }
 
   LocStreamBuf::~LocStreamBuf() {
     sync();
+
+    if (m_map != NULL)
+      munmap(m_map, m_map_size);
   }
 
   Location LocStreamBuf::get_loc() {
-    if (m_loc.total_chr != (gptr() - eback())) {
-      return upd_loc();
-    }
-
-    return m_loc;
+    return { (uint32_t)(m_base + (gptr() - eback())), m_file };
   }
 
+  void LocStreamBuf::commit() {
+    m_commit = m_base + (gptr() - eback());
 
-  Location LocStreamBuf::upd_loc() {
-    std::streampos prev_pos = m_loc.total_chr;
-    std::streampos curr_pos = (gptr() - eback());
-    char *beg = eback();
-    char *end = egptr();
-
-    //TODO: if its been saved:
-    //if its easier to count from beg:
-    if (labs(curr_pos - prev_pos) > curr_pos) {
-      m_loc.line = 1;
-      m_loc.chr = 0;
-      for (int i = 0; i < curr_pos; i++) {
-        if (i > 0 && beg[i-1] == '\n') {
-          m_loc.line++;
-          m_loc.chr = 0;
-        } else {
-          m_loc.chr++;
-        }
-      }
-    } else if (curr_pos > prev_pos) {
-      //if its easier to count form curpos back/forward to pos:
-
-      // count forwards to adjust location
-      for (long i = prev_pos; i < curr_pos; i++) {
-        if (beg[i] == '\n') {
-          m_loc.line++;
-          m_loc.chr = 0;
-        } else {
-          m_loc.chr++;
-        }
-      }
-    } else {
-      // count backwards to adjust
-      for (long i = prev_pos; i > curr_pos; i--) {
-        m_loc.total_chr--;
-        if (i+1 < (end - beg) && beg[i+1] == '\n')
-          m_loc.line--;
-      }
-      m_loc.chr = 0;
-      for (long i = curr_pos; (i > 0) && !(i > 1 && beg[i-2] == '\n'); i--)
-        m_loc.chr++;
-    }
+    // only drop the committed prefix once it is worth the move
+    std::streamoff drop = m_commit - m_base;
+    if (m_map != NULL || drop < block_size || drop < (egptr() - gptr()))
+      return;
 
-    m_loc.total_chr = curr_pos;
+    m_buf.erase(m_buf.begin(), m_buf.begin() + drop);
+    m_base = m_commit;
 
-    return m_loc;
+    char *beg = m_buf.data();
+    setg(beg, beg, beg + m_buf.size());
   }
 
-
   std::streambuf *LocStreamBuf::setbuf(char *s, std::streamsize n) {
     // return m_sb->pubsetbuf(s, n);
     return this;
@@ -98,11 +107,11 @@ namespace Parser {
       break;
 
     case std::ios_base::cur:
-      rel = cur - beg;
+      rel = m_base + (cur - beg);
       break;
 
     case std::ios_base::end:
-      rel = end - beg;
+      rel = m_base + (end - beg);
       break;
 
     default:
@@ -122,10 +131,11 @@ namespace Parser {
     char *beg = eback();
     char *end = egptr();
 
-    if (pos < 0 || pos > (end - beg))
+    // positions are absolute, the buffer only holds what's past m_base
+    if (pos < m_commit || pos > m_base + (end - beg))
       return -1;
 
-    setg(beg, beg+pos, end);
+    setg(beg, beg + (pos - m_base), end);
 
     return pos;
   }
@@ -157,111 +167,99 @@ namespace Parser {
   // }
 
   int LocStreamBuf::underflow() {
-    int r = EOF;
+    if (gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
 
-    if (gptr() < egptr()) {
-      r = *gptr();
-    } else if (m_sb != NULL) {
-      r = m_sb->sbumpc();
-      if (r != EOF) {
+    if (m_sb == NULL || m_sb->sgetc() == EOF)
+      return EOF;
 
-        m_buf.push_back(r);
+    // take whatever the wrapped buffer has ready (at least one byte, so
+    // this only blocks when it would have blocked anyway)
+    std::streamsize n = std::clamp<std::streamsize>(m_sb->in_avail(),
+                                                    1, block_size);
 
-        char *beg = m_buf.data();
-        size_t size = m_buf.size();
+    std::streamoff off = gptr() - eback();
+    size_t size = m_buf.size();
 
-        setg(beg, beg+size-1, beg+size);
-      }
-    }
+    m_buf.resize(size + n);
+    n = m_sb->sgetn(m_buf.data() + size, n);
+    m_buf.resize(size + n);
+
+    char *beg = m_buf.data();
+    setg(beg, beg + off, beg + m_buf.size());
+    Files::index(m_file, m_base + size, beg + size, beg + size + n);
 
+    if (n == 0)
+      return EOF;
 
-    return r;
+    return traits_type::to_int_type(*gptr());
   }
 
   int LocStreamBuf::uflow() {
     if ( underflow() == EOF ) return EOF;
 
     gbump(1);
-    return gptr()[-1];
+    return traits_type::to_int_type(gptr()[-1]);
   }
 
 
-  void CharSet::add(char c) {
-    m_chars.push_back(c);
-  }
+  // TODO: make this prettier
+  std::string CharSet::to_string() const {
+    std::stringstream r;
 
-  void CharSet::add(Predicate p) {
-    m_preds.push_back(p);
-  }
+    bool first = true;
+    for (int c = 0; c < 256; c++) {
+      if (!(m_chars[c >> 6] & bit(c)))
+        continue;
 
-  void CharSet::add(DescPredicate dp) {
-    add(dp.pred);
-    m_pred_descs.push_back(dp.desc);
-  }
+      if (!first) r << ", ";
+      else first = false;
 
-  void CharSet::add(std::vector<char> cs) {
-    m_chars.reserve(m_chars.capacity() + cs.size());
-    for (auto c : cs)
-      add(c);
-    // m_chars.push_back(c);
-  }
+      r << "`" << (char)c << "`";
+    }
 
-  void CharSet::add(std::vector<Predicate> ps) {
-    m_preds.reserve(m_preds.capacity() + ps.size());
-    for (auto p : ps)
-      add(p);
-    // m_preds.push_back(p);
-  }
+    for (unsigned int i = 0; i < m_ndescs; i++) {
+      if (!first) r << ", ";
+      else first = false;
 
-  void CharSet::add(CharSet s) {
-    add(s.m_chars);
-    add(s.m_preds);
-  }
+      r << m_descs[i];
+    }
 
-  // CharSet& CharSet::operator=(char c) {
-  //   return operator=(CharSet(c));
-  // }
-  // CharSet& CharSet::operator=(const Predicate c) {
-  //   return operator=(CharSet(c));
-  // }
+    return r.str();
+  }
 
-  bool CharSet::contains(char c) const {
-    for (char mc : m_chars)
-      if (c == mc)
-        return true;
 
-    for (auto mp : m_preds)
-      if (mp(c))
-        return true;
 
-    return false;
+  void Failures::fail(size_t pos, Location loc, std::string msg) {
+    if (reach(pos, loc))
+      m_msgs.push_back(std::move(msg));
   }
 
+  std::string Failures::message(const std::string &got) const {
+    static const char *const kinds[Kinds] = {
+      "character from: ", "word starting with: ", "number starting with: "
+    };
 
-  // TODO: make this prettier
-  std::string CharSet::to_string() const {
-    std::stringstream r;
+    std::string r;
+    for (auto &msg : m_msgs)
+      r += msg + "\n";
 
-    // r << "{ ";
-    bool first = true;
-    for (auto &c : m_chars) {
-      if (!first) r << ", ";
-      else first = false;
+    if (m_kinds == 0)
+      return r.empty() ? r : r.substr(0, r.size() - 1);
 
-      r << "`" << c << "`";
-    }
+    r += "Expected ";
+    bool first = true;
+    for (int k = 0; k < Kinds; k++) {
+      if (!(m_kinds & (1 << k)))
+        continue;
 
-    if (!first) r << ", ";
-    first = true;
-    for (auto &p : m_pred_descs) {
-      if (!first) r << ", ";
+      if (!first) r += " or ";
       else first = false;
 
-      r << p;
+      r += kinds[k] + m_expected[k].to_string();
     }
-    // r << " }";
 
-    return r.str();
+    return r + "\nGot: " + got;
   }
 
 
@@ -271,6 +269,10 @@ namespace Parser {
     // rdbuf(is.rdbuf());
   }
 
+  IParseStream::IParseStream(const std::string &filename) {
+    rdbuf(new LocStreamBuf(filename));
+  }
+
   IParseStream::~IParseStream() {
     delete rdbuf();
   }
@@ -283,56 +285,153 @@ namespace Parser {
     return lrdbuf()->get_loc();
   }
 
-  std::string IParseStream::get_while(std::function<bool(char)> pred) {
-    std::string r;
+  void IParseStream::commit() {
+    lrdbuf()->commit();
+  }
+
+  ParseCursor IParseStream::cursor() {
+    return ParseCursor(*lrdbuf());
+  }
 
-    while (pred(peek()))
-      r += get();
 
-    return r;
+  ParseCursor::ParseCursor(const char *beg, const char *end,
+                           std::string filename)
+    : m_beg(beg), m_cur(beg), m_end(end), m_base(0),
+      m_src(NULL), m_file(Files::add(filename)) {
+    Files::index(m_file, 0, beg, end);
   }
 
-  std::string IParseStream::many_of(const CharSet &set) {
-    std::string r;
+  ParseCursor::ParseCursor(std::string_view buf, uint32_t file, size_t base)
+    : m_beg(buf.data()), m_cur(buf.data()), m_end(buf.data() + buf.size()),
+      m_base(base), m_src(NULL), m_file(file) {}
+
+  ParseCursor::ParseCursor(LocStreamBuf &src)
+    : m_src(&src), m_file(src.m_file) {
+    load();
+  }
 
-    while (set.contains(peek()))
-      r += get();
+  void ParseCursor::store() {
+    char *beg = m_src->eback();
+    m_src->setg(beg, beg + (m_cur - m_beg), m_src->egptr());
+  }
 
-    return r;
+  void ParseCursor::load() {
+    m_beg  = m_src->eback();
+    m_cur  = m_src->gptr();
+    m_end  = m_src->egptr();
+    m_base = m_src->m_base;
   }
 
-  // template<class Fn,
-  //          class R>
-  //          // class R = decltype(std::invoke(std::declval<Fn>(),
-  //          //                                std::declval<IParseStream&>()))>
-  char IParseStream::one_of(const CharSet &set) {
-    if (set.contains(peek()))
-      return get();
+  bool ParseCursor::fill() {
+    if (m_src == NULL)
+      return false;
+
+    store();
+    bool more = m_src->underflow() != EOF;
+    load();
 
-    throw Error(get_loc(),
-                "Expected character from: "+set.to_string()+
-                "\nGot: '"+(char)peek()+"'");
+    return more;
   }
 
-  std::optional<char> IParseStream::maybe_of(const CharSet &set) {
-    try {
-      return one_of(set);
-    } catch (Error) {
-      return std::nullopt;
-    }
+  Location ParseCursor::get_loc() {
+    return { (uint32_t)tell(), m_file };
+  }
+
+  void ParseCursor::commit() {
+    forget();
+
+    if (m_src == NULL)
+      return;
+
+    store();
+    m_src->commit();
+    load();
+  }
+
+  std::string_view ParseCursor::rest() {
+    size_t pos = tell();
+
+    do {
+      m_cur = m_end;
+    } while (fill());
+
+    seek(pos);
+    return std::string_view(m_cur, m_end - m_cur);
+  }
+
+  std::string_view ParseCursor::get_while(std::function<bool(char)> pred) {
+    size_t start = tell();
+
+    while (peek() != EOF && pred(*m_cur))
+      m_cur++;
+
+    // m_beg may have moved if more input was pulled in, offsets haven't
+    const char *beg = m_beg + (start - m_base);
+    return std::string_view(beg, m_cur - beg);
+  }
+
+  std::string_view ParseCursor::many_of(const CharSet &set) {
+    size_t start = tell();
+
+    do {
+      m_cur = Scan::span(set, m_cur, m_end);
+    } while (m_cur == m_end && fill());
+
+    const char *beg = m_beg + (start - m_base);
+    return std::string_view(beg, m_cur - beg);
+  }
+
+  Result<std::string_view> ParseCursor::lexeme(const CharSet &first,
+                                               const CharSet &rest) {
+    size_t start = tell();
+
+    auto c = one_of(first);
+    if (!c)
+      return c.failure();
+
+    many_of(rest);
+
+    const char *beg = m_beg + (start - m_base);
+    return std::string_view(beg, m_cur - beg);
+  }
+
+  std::optional<char> ParseCursor::maybe_of(const CharSet &set) {
+    int c = peek();
+    if (c != EOF && set.contains(c))
+      return (char)get();
+
+    return std::nullopt;
+  }
+
+  Failure ParseCursor::fail(std::string msg) {
+    m_failures.fail(tell(), get_loc(), std::move(msg));
+    return Failure();
+  }
+
+  Error ParseCursor::error() {
+    if (m_failures.empty())
+      return Error(get_loc());
+
+    size_t pos = tell();
+    seek(m_failures.pos());
+    int c = peek();
+    seek(pos);
+
+    return Error(m_failures.loc(),
+                 m_failures.message(c == EOF ? "end of file"
+                                    : std::string("'") + (char)c + "'"));
   }
 
-  void IParseStream::skip_ws() {
-    while(std::isspace(peek()))
-      get();
+  void ParseCursor::skip_ws() {
+    many_of(Scan::whitespace);
   }
 
-  void IParseStream::throw_on_eof() {
+  void ParseCursor::throw_on_eof() {
     if (peek() == EOF)
       throw UnexpectedEOF(get_loc());
   }
 
-  IParseStream &IParseStream::begin_token() {
+  ParseCursor &ParseCursor::begin_token() {
     skip_ws();
     throw_on_eof();
 
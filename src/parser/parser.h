@@ -2,6 +2,7 @@
 #define PARSER_H
 
 #include <string>
+#include <string_view>
 #include <istream>
 #include <ios>
 #include <locale>
@@ -11,31 +12,63 @@
 #include <initializer_list>
 #include <type_traits>
 #include <memory>
+#include <cstdint>
+#include <utility>
+#include <unordered_map>
+#include <optional>
+#include <chrono>
+#include <atomic>
 
 #include "location.h"
 #include "exceptions.h"
+#include "result.h"
+#include "arena.h"
 
 namespace Parser {
 
-  template<class Parsable>
-  class Parser;
-
   class IParseStream;
+  class ParseCursor;
 
   // NOTE: this might be better done by extending stringbuf
   class LocStreamBuf : public std::streambuf {
   public:
     LocStreamBuf(std::streambuf *sb,
                  std::string filename = "-");
+    /// Map the whole file into memory and read straight from the mapping
+    LocStreamBuf(const std::string &filename);
     ~LocStreamBuf() override;
 
     Location get_loc();
-    Location upd_loc();
+
+    /// Forbid seeking before the current position
+
+    /// Everything before the commit point may be dropped from the
+    /// buffer, so backtracking can only go as far back as this.
+    void commit();
+
+    /// The whole file when it is mmapped, empty otherwise
+    std::string_view mapping() const {
+      return std::string_view(m_map, m_map_size);
+    }
+
+    /// How many bytes to pull from the wrapped streambuf at most at once
+    static constexpr std::streamsize block_size = 1 << 16;
+
+    friend ParseCursor;
 
   private:
     std::streambuf *m_sb;
     std::vector<char> m_buf;
-    Location m_loc;
+    uint32_t m_file;
+
+    // absolute offset of eback()
+    std::streamoff m_base;
+    // absolute offset of the last commit
+    std::streamoff m_commit;
+
+    // set when reading from an mmapped file
+    char  *m_map;
+    size_t m_map_size;
 
   protected:
     std::streambuf *setbuf(char *s, std::streamsize n) override;
@@ -56,89 +89,262 @@ namespace Parser {
   };
 
 
+  /// Whether results of T::parse are cached (per cursor, keyed by
+  /// position), specialize to opt a rule in
   template<class T>
+  struct Memoize : std::false_type {};
+
+
+  /// How T parses on a Cursor
+
+  /// T::parse is called directly, it may be a plain function taking the
+  /// one cursor type it works on or a template over cursors (as the
+  /// grammar combinators are). Either way the call can be inlined.
+  template<class T, class Cursor>
   struct ParsableTrait {
-    using ResultType = std::invoke_result_t<decltype(T::parse), IParseStream&>;
+    static constexpr bool memoize = Memoize<T>::value;
+
+    using ResultType = decltype(T::parse(std::declval<Cursor &>()));
 
-    using ParserType = Parser<ResultType>;
+    using ValueType = typename ResultType::value_type;
 
-    static auto parse(IParseStream &in) {
+    static ResultType parse(Cursor &in) {
       return T::parse(in);
     }
-    static const Parser<ResultType> parser;
+
+    /// Identifies T's memo table
+    static constexpr char key = 0;
   };
 
-  template<class T>
-  const typename ParsableTrait<T>::ParserType ParsableTrait<T>::parser =
-    Parser(T::parse);
+  /// What parsing a T on a Cursor gives when it succeeds
+  template<class T, class Cursor>
+  using ValueOf = typename ParsableTrait<T, Cursor>::ValueType;
 
+  /// A set of bytes, stored as a 256-bit lookup table
+
+  /// Everything but to_string() is constexpr, so sets can be composed
+  /// at compile time. The descriptions and the individually added
+  /// characters are only kept around for diagnostics.
   class CharSet {
   public:
-    typedef std::function<bool(char)> Predicate;
-
     template<class Fn>
     using is_predicate_t = std::is_invocable_r<bool, Fn, char>;
 
     template<class Fn>
     using is_predicate = std::enable_if_t<is_predicate_t<Fn>::value>;
 
-    typedef struct {
-      std::string desc;
-      Predicate   pred;
-    } DescPredicate;
+    static constexpr unsigned int max_descs = 8;
 
-    CharSet() {};
+    constexpr CharSet() {};
 
 #define ctor(typ)                                         \
     template<class ...T>                                  \
-    CharSet(typ c0, T... c) : CharSet(c...) { add(c0); }
+    constexpr CharSet(typ c0, T... c) : CharSet(c...) { add(c0); }
 
     ctor(char)
-    ctor(DescPredicate)
-    ctor(Predicate)
     ctor(CharSet)
 #undef ctor
 
+    /// Every byte `p` holds for, described as `d`
     template<class Fn, class = is_predicate<Fn>>
-    CharSet(std::string d, Fn p) : CharSet(DescPredicate{d, p}) {}
+    constexpr CharSet(const char *d, Fn p) {
+      for (int c = 0; c < 256; c++)
+        if (p((char)c))
+          set(c);
+      add_desc(d);
+    }
 
-    template<class Fn, class = is_predicate<Fn>>
-    CharSet(Fn p) : CharSet(Predicate(p)) {}
+    /// The bytes of `s`, described as `d` instead
+    constexpr CharSet(const char *d, const CharSet &s) {
+      for (int i = 0; i < 4; i++)
+        m_bits[i] = s.m_bits[i];
+      for (int i = 0; i < 16; i++) {
+        m_nibs[0][i] = s.m_nibs[0][i];
+        m_nibs[1][i] = s.m_nibs[1][i];
+      }
+      add_desc(d);
+    }
+
+    /// All bytes from `lo` to `hi` inclusive
+    static constexpr CharSet range(char lo, char hi, const char *d) {
+      return CharSet(d, [lo, hi](char c) { return c >= lo && c <= hi; });
+    }
+
+    constexpr void add(char c) {
+      set((unsigned char)c);
+      m_chars[(unsigned char)c >> 6] |= bit((unsigned char)c);
+    }
 
+    constexpr void add(const CharSet &s) {
+      for (int i = 0; i < 4; i++) {
+        m_bits[i]  |= s.m_bits[i];
+        m_chars[i] |= s.m_chars[i];
+      }
+      for (int i = 0; i < 16; i++) {
+        m_nibs[0][i] |= s.m_nibs[0][i];
+        m_nibs[1][i] |= s.m_nibs[1][i];
+      }
+      for (unsigned int i = 0; i < s.m_ndescs; i++)
+        add_desc(s.m_descs[i]);
+    }
+
+    constexpr bool contains(char c) const {
+      return m_bits[(unsigned char)c >> 6] & bit((unsigned char)c);
+    }
 
-    void add(char);
-    void add(Predicate);
-    void add(DescPredicate);
-    void add(std::vector<char>);
-    void add(std::vector<Predicate>);
-    void add(CharSet);
+    /// Whether every byte of `s` is in this set
+    constexpr bool includes(const CharSet &s) const {
+      for (int i = 0; i < 4; i++)
+        if ((m_bits[i] & s.m_bits[i]) != s.m_bits[i])
+          return false;
+      return true;
+    }
 
-    bool contains(char) const;
+    /// The set by low nibble: bit `h` of nibbles(c >= 0x80)[c & 0xf] is
+    /// set iff c is in the set, where h is bits 4-6 of c. This is the
+    /// layout the SIMD scanners look bytes up in.
+    constexpr const uint8_t *nibbles(bool high) const {
+      return m_nibs[high];
+    }
 
     std::string to_string() const;
 
   private:
-    std::vector<char>        m_chars;
-    std::vector<Predicate>   m_preds;
-    std::vector<std::string> m_pred_descs;
+    static constexpr uint64_t bit(unsigned char c) {
+      return (uint64_t)1 << (c & 63);
+    }
+
+    constexpr void set(unsigned char c) {
+      m_bits[c >> 6] |= bit(c);
+      m_nibs[c >> 7][c & 0xf] |= 1 << ((c >> 4) & 7);
+    }
+
+    constexpr void add_desc(const char *d) {
+      // anything past max_descs only loses its description
+      if (m_ndescs < max_descs)
+        m_descs[m_ndescs++] = d;
+    }
+
+    uint64_t m_bits[4]  = { 0, 0, 0, 0 };
+    // bytes that were added on their own rather than through a description
+    uint64_t m_chars[4] = { 0, 0, 0, 0 };
+    uint8_t  m_nibs[2][16] = {};
+
+    const char *m_descs[max_descs] = {};
+    unsigned int m_ndescs = 0;
   };
 
 
+  /// The farthest position any parse failed at, and the union of what
+  /// would have been accepted there
 
-  class IParseStream : public std::istream {
+  /// Recording a failure is a compare, and an or of the expected set
+  /// into the union if it is at the farthest position. Nothing is
+  /// formatted until the parse as a whole has failed.
+  class Failures {
   public:
-    IParseStream(const std::istream &is);
-    ~IParseStream();
+    /// What an expected set is the first bytes of
+    enum Kind : uint8_t { Char, Word, Number, Kinds };
 
-    LocStreamBuf *lrdbuf();
+    /// Note that a `kind` starting with a byte from `set` would have
+    /// been accepted at cursor position `pos`, which is at `loc`
+    void expect(size_t pos, Location loc, Kind kind, const CharSet &set) {
+      if (!reach(pos, loc) || m_expected[kind].includes(set))
+        return;
+
+      m_expected[kind].add(set);
+      m_kinds |= 1 << kind;
+    }
+
+    /// Note a failure that isn't about what comes next, e.g. a literal
+    /// that is out of range
+    void fail(size_t pos, Location loc, std::string msg);
+
+    void clear() { m_any = false; }
+
+    bool empty() const { return !m_any; }
+    size_t pos() const { return m_pos; }
+    Location loc() const { return m_loc; }
+
+    /// What went wrong at the farthest position, `got` being what was
+    /// found there instead
+    std::string message(const std::string &got) const;
+
+  private:
+    // false if pos is behind the farthest failure, starts over if past it
+    bool reach(size_t pos, Location loc) {
+      if (m_any && pos < m_pos)
+        return false;
+
+      if (!m_any || pos > m_pos) {
+        m_any = true;
+        m_pos = pos;
+        m_loc = loc;
+        for (int k = 0; k < Kinds; k++)
+          if (m_kinds & (1 << k))
+            m_expected[k] = CharSet();
+        m_kinds = 0;
+        m_msgs.clear();
+      }
+      return true;
+    }
+
+    bool m_any = false;
+    size_t m_pos = 0;
+    Location m_loc = { 0, 0 };
+
+    uint8_t m_kinds = 0;
+    CharSet m_expected[Kinds];
+    std::vector<std::string> m_msgs;
+  };
 
-    Location get_loc();
 
-    std::string get_while(const std::function<bool(char)> pred);
 
+  /// The work cursors parsing parts of one input have done backtracking,
+  /// together
+  struct SharedStats {
+    std::atomic<size_t> rewinds{0};
+    std::atomic<size_t> rescanned{0};
+  };
+
+  /// Limits on the work a cursor may do backtracking, 0 is no limit
+
+  /// Inputs that make alternatives fail late can make a parse take
+  /// super-linear time, a Budget bounds that. It applies per cursor,
+  /// or to the total of all cursors counting into the same `shared`.
+  struct Budget {
+    /// How many times parsing may go back to an earlier position
+    size_t rewinds = 0;
+    /// How many bytes of input may be gone back over in total
+    size_t rescanned = 0;
+    /// When to give up, checked on commits and every 256 rewinds
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    /// Where the work is counted too, if anywhere, the limits are then
+    /// on what's counted there
+    SharedStats *shared = nullptr;
+  };
 
-    std::string many_of(const CharSet &set);
+  /// The work a cursor has done backtracking
+  struct ParseStats {
+    size_t rewinds = 0;
+    size_t rescanned = 0;
 
+    ParseStats &operator+=(const ParseStats &o) {
+      rewinds   += o.rewinds;
+      rescanned += o.rescanned;
+      return *this;
+    }
+  };
+
+
+  /// The generic combinators, shared by all cursor types
+
+  /// A Cursor needs tell() and seek() to backtrack, bytes_since(pos) to
+  /// count what backtracking re-scans and get_loc() to report where it
+  /// gave up. Everything else is up to the parsers that run on it.
+  template<class Cursor>
+  class Combinators {
+  public:
     // template<class T>
     // using IsParsableTrait = std::is_same<ParsableTrait<T>, T>;
 
@@ -148,49 +354,46 @@ namespace Parser {
     //                                          ParsableTrait<T>>;
 
     template<class ParsableTr>
-    std::vector<typename ParsableTrait<ParsableTr>::ResultType> many_of() {
-      std::vector<typename ParsableTrait<ParsableTr>::ResultType> r;
+    std::vector<ValueOf<ParsableTr, Cursor>> many_of() {
+      std::vector<ValueOf<ParsableTr, Cursor>> r;
 
       for (;;) {
-        auto p = tellg();
-        try {
-          auto rr = ParsableTrait<ParsableTr>::parser.parse(*this);
-          r.push_back(rr);
+        auto p = self().tell();
+        auto rr = parse<ParsableTr>();
 
-        } catch (Error e) {
-          seekg(p);
+        if (!rr) {
+          rewind(p);
           break;
-          // throw e;
         }
+
+        r.push_back(std::move(*rr));
       }
 
       return r;
     }
 
-    char one_of(const CharSet &set);
-
     template<class R, class ParsableTr>
-    R one_of_as() {
-      auto pos = tellg();
-      try {
-        return ParsableTrait<ParsableTr>::parser.parse(*this);
-
-      } catch (Error e) {
-        seekg(pos);
-
-        /* TODO: this should be the combination of 
-           all the failed parses to get to here */
-        throw e;
+    Result<R> one_of_as() {
+      auto pos = self().tell();
+      auto r = parse<ParsableTr>();
+
+      // what was expected is already with the cursor's Failures, the
+      // alternatives add theirs to it as they fail
+      if (!r) {
+        rewind(pos);
+        return r.failure();
       }
+
+      return Result<R>(std::move(r));
     }
 
     template<class R, class ParsableTr, class ParsableTr1, class ...Rest>
-    R one_of_as() {
-      try {
-        return one_of_as<R, ParsableTr>();
-      } catch (Error e) {
-        return one_of_as<R, ParsableTr1, Rest...>();
-      }
+    Result<R> one_of_as() {
+      auto r = one_of_as<R, ParsableTr>();
+      if (r)
+        return r;
+
+      return one_of_as<R, ParsableTr1, Rest...>();
     }
 
 
@@ -198,107 +401,352 @@ namespace Parser {
     template<class ...ParsableTrs>
     auto one_of() {
       using R = std::common_type_t<
-        typename ParsableTrait<ParsableTrs>::ResultType...>;
+        ValueOf<ParsableTrs, Cursor>...>;
 
       return one_of_as<R, ParsableTrs...>();
     }
 
 
-
-    std::optional<char> maybe_of(const CharSet &set);
-
     template<class R, class ...ParsableTrs>
     std::optional<R> maybe_of_as() {
-      try {
-        return one_of_as<R, ParsableTrs...>();
-      } catch (Error) {
+      auto r = one_of_as<R, ParsableTrs...>();
+      if (!r)
         return std::nullopt;
-      }
+
+      return std::move(*r);
     }
 
     template<class ...ParsableTrs>
     auto maybe_of() {
       using R = std::common_type_t<
-        typename ParsableTrait<ParsableTrs>::ResultType...>;
+        ValueOf<ParsableTrs, Cursor>...>;
 
       return maybe_of_as<R, ParsableTrs...>();
     }
 
+    /// Everything that failed at the farthest position so far
+    const Failures &failures() const { return m_failures; }
+
+    const Budget &budget() const { return m_budget; }
+    /// Limit the backtracking from here on, throwing BudgetExceeded
+    /// once over
+    void set_budget(const Budget &budget) { m_budget = budget; }
+
+    /// The backtracking done so far
+    const ParseStats &stats() const { return m_stats; }
+    /// Count work done on another cursor, e.g. on part of this input
+    void add_stats(const ParseStats &stats) { m_stats += stats; }
+
+    /// Where parsers put what they build
+    Arena &arena() { return *share_arena(); }
+    /// The arena, for whatever keeps the values parsed
+    const std::shared_ptr<Arena> &share_arena() {
+      if (!m_arena)
+        m_arena = std::make_shared<Arena>();
+      return m_arena;
+    }
+    /// Build in `arena` from here on, or in a new one if it's null
+    void set_arena(std::shared_ptr<Arena> arena) {
+      m_arena = std::move(arena);
+    }
 
-    void skip_ws();
-    void throw_on_eof();
-    IParseStream& begin_token();
+  protected:
+    /// Drop all cached results, and the failures before the current
+    /// position, the cursor calls this when it commits. A failure at or
+    /// past it was the farthest an alternative got, and may still be
+    /// the farthest the parse gets.
+    void forget() {
+      for (auto &table : m_memo)
+        table.second->clear();
+      if (m_failures.pos() < self().tell())
+        m_failures.clear();
+
+      check_deadline();
+    }
+
+    Failures m_failures;
+
+  private:
+    Cursor &self() { return *static_cast<Cursor *>(this); }
+
+    /// Go back to `pos` after a failed parse, and charge it to the budget
+    void rewind(size_t pos) {
+      // failing without consuming anything isn't backtracking
+      if (self().tell() == pos)
+        return;
+
+      size_t bytes = self().bytes_since(pos);
+      m_stats.rewinds++;
+      m_stats.rescanned += bytes;
+      self().seek(pos);
+
+      size_t rewinds = m_stats.rewinds, rescanned = m_stats.rescanned;
+      if (m_budget.shared) {
+        rewinds   = ++m_budget.shared->rewinds;
+        rescanned = m_budget.shared->rescanned += bytes;
+      }
+
+      if (m_budget.rewinds && rewinds > m_budget.rewinds)
+        throw BudgetExceeded(self().get_loc(),
+                             std::to_string(m_budget.rewinds) +
+                             " rewinds");
+
+      if (m_budget.rescanned && rescanned > m_budget.rescanned)
+        throw BudgetExceeded(self().get_loc(),
+                             "re-scanning " +
+                             std::to_string(m_budget.rescanned) +
+                             " bytes");
+
+      // reading the clock isn't free, don't on every rewind
+      if ((m_stats.rewinds & 255) == 0)
+        check_deadline();
+    }
+
+    void check_deadline() {
+      if (m_budget.deadline &&
+          std::chrono::steady_clock::now() > *m_budget.deadline)
+        throw BudgetExceeded(self().get_loc(), "running out of time");
+    }
+
+    Budget m_budget;
+    ParseStats m_stats;
+    std::shared_ptr<Arena> m_arena;
+
+    struct MemoTableBase {
+      virtual ~MemoTableBase() {}
+      virtual void clear() = 0;
+    };
+
+    // what parsing at an offset gave, and where it left the cursor
+    template<class R>
+    struct MemoTable : MemoTableBase {
+      std::unordered_map<size_t, std::pair<R, size_t>> entries;
+
+      void clear() override { entries.clear(); }
+    };
+
+    /// Run a parser, going through its memo table if it has one
+    template<class ParsableTr>
+    auto parse() {
+      using Trait = ParsableTrait<ParsableTr, Cursor>;
+
+      if constexpr (!Trait::memoize) {
+        return Trait::parse(self());
+
+      } else {
+        auto &table = memo_table<typename Trait::ResultType>(&Trait::key);
+
+        size_t pos = self().tell();
+        auto it = table.entries.find(pos);
+        if (it != table.entries.end()) {
+          self().seek(it->second.second);
+          return it->second.first;
+        }
+
+        auto r = Trait::parse(self());
+        table.entries.emplace(pos, std::make_pair(r, self().tell()));
+
+        return r;
+      }
+    }
+
+    template<class R>
+    MemoTable<R> &memo_table(const void *key) {
+      // only a handful of parsers are memoized, a scan beats a hash
+      for (auto &table : m_memo)
+        if (table.first == key)
+          return static_cast<MemoTable<R> &>(*table.second);
+
+      m_memo.emplace_back(key, std::make_unique<MemoTable<R>>());
+      return static_cast<MemoTable<R> &>(*m_memo.back().second);
+    }
+
+    std::vector<std::pair<const void *,
+                          std::unique_ptr<MemoTableBase>>> m_memo;
   };
 
 
-  template<class ParsableT>
-  class Parser {
+  /// A position in a contiguous input buffer
+
+  /// All parsers run on this. It reads straight from memory and only
+  /// calls out to its LocStreamBuf (if any) when it runs off the end of
+  /// what is buffered, or to commit and resolve locations.
+  class ParseCursor : public Combinators<ParseCursor> {
   public:
-    typedef ParsableT Parsable;
+    /// Parse an in-memory buffer
+    ParseCursor(const char *beg, const char *end,
+                std::string filename = "-");
+    /// Parse part of an input that is already in the file table, `buf`
+    /// starts at offset `base` of input `file`
+    ParseCursor(std::string_view buf, uint32_t file, size_t base);
+    /// Parse from the current position of a LocStreamBuf, pulling more
+    /// input from it as needed
+    ParseCursor(LocStreamBuf &src);
+
+    int peek() {
+      if (m_cur == m_end && !fill())
+        return EOF;
+      return (unsigned char)*m_cur;
+    }
 
-    typedef std::function<Parsable(IParseStream &)> PFunc;
+    int get() {
+      int c = peek();
+      if (c != EOF)
+        m_cur++;
+      return c;
+    }
 
-    template<class Fn>
-    Parser(Fn f, std::optional<std::string> d = std::nullopt)
-      : m_func(f), m_desc(d) {}
+    /// Absolute offset of the current position
+    size_t tell() const { return m_base + (m_cur - m_beg); }
+    /// Rewind (or skip) to an offset previously returned by tell()
+    void seek(size_t pos) { m_cur = m_beg + (pos - m_base); }
+    /// How many bytes lie between `pos` and the current position
+    size_t bytes_since(size_t pos) const { return tell() - pos; }
 
+    Location get_loc();
 
-    std::string to_string() const;
+    uint32_t file() const { return m_file; }
 
-    friend IParseStream;
+    /// The byte ParserSets dispatch on
+    int lookahead() { return peek(); }
 
-  private:
-    Parsable parse(IParseStream &in) const {
-      return m_func(in);
+    void commit();
+
+    /// Everything from the current position to the end of the input,
+    /// reading in whatever hasn't been buffered yet
+    std::string_view rest();
+
+    /// The returned views point into the input buffer, they stay valid
+    /// until more input is pulled in or the cursor commits
+    std::string_view get_while(const std::function<bool(char)> pred);
+
+
+    std::string_view many_of(const CharSet &set);
+
+    /// One char from `first` followed by any number from `rest`
+    Result<std::string_view> lexeme(const CharSet &first,
+                                    const CharSet &rest);
+
+    using Combinators<ParseCursor>::many_of;
+    using Combinators<ParseCursor>::one_of;
+    using Combinators<ParseCursor>::maybe_of;
+
+    Result<char> one_of(const CharSet &set) {
+      int c = peek();
+      if (c != EOF && set.contains(c))
+        return (char)get();
+
+      m_failures.expect(tell(), get_loc(), Failures::Char, set);
+      return Failure();
     }
+    std::optional<char> maybe_of(const CharSet &set);
 
-    PFunc m_func;
-    std::optional<std::string> m_desc;
+    /// Fail here for a reason other than what comes next
+    Failure fail(std::string msg);
+    /// The Error for the farthest failure since the last commit
+    Error error();
 
-  };
+    void skip_ws();
+    void throw_on_eof();
+    ParseCursor& begin_token();
 
-  template<class Fn>
-  Parser(Fn, std::optional<std::string> = std::nullopt)
-    -> Parser<decltype(std::invoke(std::declval<Fn>(),
-                                   std::declval<IParseStream&>()))>;
+  private:
+    // pull more input from m_src, false at EOF
+    bool fill();
+    // hand the current position back to / reload pointers from m_src
+    void store();
+    void load();
+
+    const char *m_beg;
+    const char *m_cur;
+    const char *m_end;
+    // absolute offset of m_beg
+    size_t m_base;
+
+    LocStreamBuf *m_src;
+    uint32_t m_file;
+  };
 
 
-  template<class Parsable>
-  class ParserSet {
+  /// std::istream adapter over a LocStreamBuf
+  class IParseStream : public std::istream {
   public:
-    // typedef std::function<Parsable(IParseStream &)> Parser;
+    IParseStream(const std::istream &is);
+    IParseStream(const std::string &filename);
+    ~IParseStream();
 
-    // template<class Fn>
-    // using is_parser_t = std::is_invocable_r<Parsable, Fn, IParseStream &>;
+    LocStreamBuf *lrdbuf();
 
-    // template<class Fn>
-    // using is_parser = std::enable_if_t<is_parser_t<Fn>::value>;
+    Location get_loc();
 
+    void commit();
 
-    ParserSet() {};
+    /// A cursor starting at the current position of the stream
+    ParseCursor cursor();
+  };
 
-#define ctor(typ)                                             \
-    template<class ...T>                                      \
-    ParserSet(typ c0, T... c) : ParserSet(c...) { add(c0); }
 
-    ctor(typename Parser<Parsable>::PFunc)
-    ctor(ParserSet)
-#undef ctor
+  /// The bytes a T can start with, for a TokenCursor the first byte of
+  /// its first token. Specialize to let a ParserSet skip T elsewhere.
+  template<class T>
+  struct First {
+    static constexpr CharSet set = CharSet("anything",
+                                           [](char) { return true; });
+  };
 
-    // template<class Fn, class = is_parser<Fn>>
-    // ParserSet(std::string d, Fn p) : ParserSet(DescParser{d, p}) {}
 
-    // template<class Fn, class = is_parser<Fn>>
-    // ParserSet(Fn p) : ParserSet(Predicate(p)) {}
+  /// An alternation that dispatches on the lookahead byte
 
+  /// A 256-entry table, built at compile time from the First sets, maps
+  /// the byte to the alternatives that can start with it. Only those
+  /// are tried, in the order given, so the result is the same as
+  /// one_of_as<R, ParsableTrs...>() wherever the First sets are right.
+  template<class R, class ...ParsableTrs>
+  class ParserSet {
+  public:
+    static_assert(sizeof...(ParsableTrs) <= 32,
+                  "a ParserSet dispatches on a 32-bit mask");
 
-    void add(Parser<Parsable>);
-    void add(ParserSet<Parsable>);
+    template<class Cursor>
+    static Result<R> parse(Cursor &in) {
+      int c = in.lookahead();
+      uint32_t alts = c == EOF ? 0 : table.alts[(unsigned char)c];
 
-    std::string to_string() const;
+      // nothing can start here, but let every alternative fail anyway
+      // so each notes what it expected
+      if (alts == 0)
+        alts = ~(uint32_t)0;
+
+      return parse(in, alts, std::index_sequence_for<ParsableTrs...>());
+    }
 
   private:
-    std::vector<Parser<Parsable>> m_parsers;
+    struct Table {
+      uint32_t alts[256] = {};
+
+      constexpr Table() {
+        const CharSet *firsts[] = { &First<ParsableTrs>::set... };
+
+        for (unsigned int i = 0; i < sizeof...(ParsableTrs); i++)
+          for (int c = 0; c < 256; c++)
+            if (firsts[i]->contains((char)c))
+              alts[c] |= (uint32_t)1 << i;
+      }
+    };
+
+    static constexpr Table table = Table();
+
+    template<class Cursor, size_t ...I>
+    static Result<R> parse(Cursor &in, uint32_t alts,
+                           std::index_sequence<I...>) {
+      Result<R> r = Failure();
+
+      // stops at the first alternative that parses
+      ((alts & ((uint32_t)1 << I) &&
+        (r = in.template one_of_as<R, ParsableTrs>())) || ...);
+
+      return r;
+    }
   };
 
   
@@ -0,0 +1,163 @@
+#ifndef PARSER_PRECEDENCE_H
+#define PARSER_PRECEDENCE_H
+
+#include <cstdint>
+#include <utility>
+
+#include "parser.h"
+#include "small_vector.h"
+
+namespace Parser {
+
+  /// The prefix and infix operators of an expression grammar
+
+  /// Operators are single bytes (single Punct tokens on a TokenCursor)
+  /// and are looked up in 256-entry tables. A precedence of 0 means
+  /// "not an operator", higher binds tighter. Tables are built at
+  /// compile time:
+  ///
+  ///     static constexpr Operators operators = Operators()
+  ///       .infix('+', 1).infix('*', 2).prefix('-', 3);
+  class Operators {
+  public:
+    enum Assoc : uint8_t { Left, Right };
+
+    struct Op {
+      uint8_t prec  = 0;
+      Assoc   assoc = Left;
+    };
+
+    /// These operators and `c` as an infix operator
+    constexpr Operators infix(char c, uint8_t prec,
+                              Assoc assoc = Left) const {
+      Operators r = *this;
+      r.m_infix[(unsigned char)c] = { prec, assoc };
+      r.m_infixes.add(c);
+      return r;
+    }
+
+    /// These operators and `c` as a prefix operator
+    constexpr Operators prefix(char c, uint8_t prec) const {
+      Operators r = *this;
+      r.m_prefix[(unsigned char)c] = prec;
+      return r;
+    }
+
+    constexpr Op infix_of(char c) const {
+      return m_infix[(unsigned char)c];
+    }
+
+    constexpr uint8_t prefix_of(char c) const {
+      return m_prefix[(unsigned char)c];
+    }
+
+    /// Every infix operator, for diagnostics
+    constexpr const CharSet &infixes() const { return m_infixes; }
+
+  private:
+    Op      m_infix[256]  = {};
+    uint8_t m_prefix[256] = {};
+    CharSet m_infixes;
+  };
+
+
+  /// The operands and operators of one expression, as they are read
+
+  /// Whatever binds tighter than an incoming infix operator is applied
+  /// before it is pushed (shunting-yard), so however long a chain of
+  /// prefix or right-associative operators gets, nothing recurses. The
+  /// tree built is the one precedence climbing would build. Ops builds
+  /// the nodes, with static Ops::infix(in, op, lhs, rhs) and
+  /// Ops::prefix(in, op, operand), `in` being the cursor.
+  template<class Ops, class Value>
+  class OperatorStack {
+  public:
+    /// Take any prefix operators next
+    template<class Cursor>
+    void prefixes(Cursor &in) {
+      for (int c = in.lookahead(); c != EOF && ops.prefix_of(c);
+           c = in.lookahead()) {
+        in.get();
+        m_ops.push_back({ (char)c, true });
+      }
+    }
+
+    void operand(Value v) { m_operands.push_back(std::move(v)); }
+
+    /// Take an infix operator if one is next, false if there is none
+    template<class Cursor>
+    bool infix(Cursor &in) {
+      int c = in.lookahead();
+      Operators::Op op = c == EOF ? Operators::Op() : ops.infix_of(c);
+
+      if (op.prec == 0) {
+        // an operator would have done here too, note that
+        in.maybe_of(ops.infixes());
+        return false;
+      }
+
+      in.get();
+      while (!m_ops.empty() && takes_operand(m_ops.back(), op.prec))
+        reduce(in);
+
+      m_ops.push_back({ (char)c, false });
+      return true;
+    }
+
+    /// The whole expression, after its last operand
+    template<class Cursor>
+    Value finish(Cursor &in) {
+      while (!m_ops.empty())
+        reduce(in);
+
+      Value r = std::move(m_operands.back());
+      m_operands.pop_back();
+      return r;
+    }
+
+  private:
+    static constexpr const Operators &ops = Ops::operators;
+
+    struct Pending {
+      char c;
+      bool prefix;
+    };
+
+    // whether `p` gets the operand before an infix operator of `prec`
+    static bool takes_operand(Pending p, uint8_t prec) {
+      if (p.prefix)
+        return ops.prefix_of(p.c) > prec;
+
+      Operators::Op op = ops.infix_of(p.c);
+      return op.assoc == Operators::Left ? op.prec >= prec : op.prec > prec;
+    }
+
+    // apply the last operator to the last operands
+    template<class Cursor>
+    void reduce(Cursor &in) {
+      Pending p = m_ops.back();
+      m_ops.pop_back();
+
+      Value rhs = std::move(m_operands.back());
+      m_operands.pop_back();
+
+      if (p.prefix) {
+        m_operands.push_back(Ops::prefix(in, p.c, std::move(rhs)));
+        return;
+      }
+
+      Value lhs = std::move(m_operands.back());
+      m_operands.pop_back();
+
+      m_operands.push_back(Ops::infix(in, p.c, std::move(lhs),
+                                       std::move(rhs)));
+    }
+
+    // most expressions are a few operands long
+    SmallVector<Pending, 4> m_ops;
+    SmallVector<Value, 4>   m_operands;
+  };
+
+}
+
+#endif
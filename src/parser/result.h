@@ -0,0 +1,51 @@
+#ifndef PARSER_RESULT_H
+#define PARSER_RESULT_H
+
+#include <variant>
+#include <utility>
+#include <type_traits>
+
+namespace Parser {
+
+  /// Marks a failed parse, what was expected is kept by the cursor
+  struct Failure {};
+
+  /// The outcome of a parse: either a value or a Failure
+
+  /// Failing is the normal case while backtracking, so it is an ordinary
+  /// return value that costs a branch. The cursor turns the farthest
+  /// failure into an Error once the parse as a whole has failed.
+  template<class T>
+  class Result {
+  public:
+    using value_type = T;
+
+    Result(T val) : m_val(std::in_place_index<0>, std::move(val)) {}
+    Result(Failure f) : m_val(std::in_place_index<1>, f) {}
+
+    /// From the Result of something convertible to T, e.g. a derived node
+    template<class U, class = std::enable_if_t<
+                        std::is_convertible_v<U, T> && !std::is_same_v<U, T>>>
+    Result(Result<U> other)
+      : m_val(other
+              ? Variant(std::in_place_index<0>, std::move(*other))
+              : Variant(std::in_place_index<1>, other.failure())) {}
+
+    explicit operator bool() const { return m_val.index() == 0; }
+
+    T       &operator*()       { return std::get<0>(m_val); }
+    const T &operator*() const { return std::get<0>(m_val); }
+    T       *operator->()       { return &std::get<0>(m_val); }
+    const T *operator->() const { return &std::get<0>(m_val); }
+
+    Failure failure() const { return Failure(); }
+
+  private:
+    using Variant = std::variant<T, Failure>;
+
+    Variant m_val;
+  };
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace Parser {
+  namespace Scan {
+    typedef const char *(*SpanFn)(const CharSet &, const char *, const char *);
+
+    const char *span_scalar(const CharSet &set,
+                            const char *beg, const char *end) {
+      while (beg < end && set.contains(*beg))
+        beg++;
+      return beg;
+    }
+
+#ifdef SCAN_X86
+    // Bytes are classified 16/32 at a time with two nibble lookups: the
+    // low nibble picks a row of set.nibbles(), the high nibble picks the
+    // bit in that row. SSE2 has no byte shuffle, so the narrowest vector
+    // kernel needs SSSE3.
+
+    __attribute__((target("ssse3")))
+    static const char *ssse3(const CharSet &set,
+                             const char *beg, const char *end) {
+      const __m128i lo_tbl = _mm_loadu_si128((const __m128i *)set.nibbles(false));
+      const __m128i hi_tbl = _mm_loadu_si128((const __m128i *)set.nibbles(true));
+      const __m128i bits   = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                           1, 2, 4, 8, 16, 32, 64, -128);
+      const __m128i nib    = _mm_set1_epi8(0x0f);
+      const __m128i zero   = _mm_setzero_si128();
+
+      for (; end - beg >= 16; beg += 16) {
+        __m128i x  = _mm_loadu_si128((const __m128i *)beg);
+        __m128i lo = _mm_and_si128(x, nib);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), nib);
+
+        // bytes >= 0x80 look up the high half of the table
+        __m128i top = _mm_cmplt_epi8(x, zero);
+        __m128i row = _mm_or_si128(
+          _mm_andnot_si128(top, _mm_shuffle_epi8(lo_tbl, lo)),
+          _mm_and_si128   (top, _mm_shuffle_epi8(hi_tbl, lo)));
+
+        __m128i hit = _mm_and_si128(row, _mm_shuffle_epi8(bits, hi));
+        int miss = _mm_movemask_epi8(_mm_cmpeq_epi8(hit, zero));
+
+        if (miss)
+          return beg + __builtin_ctz(miss);
+      }
+
+      return span_scalar(set, beg, end);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *avx2(const CharSet &set,
+                            const char *beg, const char *end) {
+      const __m256i lo_tbl = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)set.nibbles(false)));
+      const __m256i hi_tbl = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)set.nibbles(true)));
+      const __m256i bits   = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                              1, 2, 4, 8, 16, 32, 64, -128,
+                                              1, 2, 4, 8, 16, 32, 64, -128,
+                                              1, 2, 4, 8, 16, 32, 64, -128);
+      const __m256i nib    = _mm256_set1_epi8(0x0f);
+      const __m256i zero   = _mm256_setzero_si256();
+
+      for (; end - beg >= 32; beg += 32) {
+        __m256i x  = _mm256_loadu_si256((const __m256i *)beg);
+        __m256i lo = _mm256_and_si256(x, nib);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nib);
+
+        __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(lo_tbl, lo),
+                                         _mm256_shuffle_epi8(hi_tbl, lo),
+                                         x);
+
+        __m256i hit = _mm256_and_si256(row, _mm256_shuffle_epi8(bits, hi));
+        unsigned int miss =
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(hit, zero));
+
+        if (miss)
+          return beg + __builtin_ctz(miss);
+      }
+
+      return ssse3(set, beg, end);
+    }
+#endif
+
+    static SpanFn pick() {
+#ifdef SCAN_X86
+      __builtin_cpu_init();
+
+      if (__builtin_cpu_supports("avx2"))
+        return avx2;
+      if (__builtin_cpu_supports("ssse3"))
+        return ssse3;
+#endif
+      return span_scalar;
+    }
+
+    const char *span(const CharSet &set, const char *beg, const char *end) {
+      // most spans (identifiers, digits, indentation) are short, don't
+      // bother with the indirect call for them
+      if (end - beg < 16)
+        return span_scalar(set, beg, end);
+
+      static const SpanFn fn = pick();
+      return fn(set, beg, end);
+    }
+  }
+}
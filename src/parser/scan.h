@@ -0,0 +1,28 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "parser.h"
+
+namespace Parser {
+
+  /// Bulk scanning of contiguous input against a CharSet
+  namespace Scan {
+    /// What std::isspace accepts in the "C" locale
+    constexpr CharSet whitespace = CharSet("whitespace",
+                                           CharSet(' ', '\t', '\n',
+                                                   '\v', '\f', '\r'));
+
+    /// The first byte in [beg, end) that is not in `set`, or `end`
+
+    /// Dispatches once, on first use, to the widest kernel the CPU
+    /// supports.
+    const char *span(const CharSet &set, const char *beg, const char *end);
+
+    /// The byte-at-a-time fallback
+    const char *span_scalar(const CharSet &set,
+                            const char *beg, const char *end);
+  }
+
+}
+
+#endif
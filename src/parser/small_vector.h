@@ -0,0 +1,164 @@
+#ifndef PARSER_SMALL_VECTOR_H
+#define PARSER_SMALL_VECTOR_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <initializer_list>
+
+namespace Parser {
+
+  /// A vector that keeps up to N elements inline
+
+  /// Argument lists and the like are nearly always short, this saves
+  /// them a heap allocation each. Only the part of std::vector's
+  /// interface the parsers and the AST use is here.
+  template<class T, size_t N>
+  class SmallVector {
+  public:
+    using value_type     = T;
+    using iterator       = T *;
+    using const_iterator = const T *;
+
+    SmallVector() : m_heap(nullptr), m_size(0), m_cap(N) {}
+
+    SmallVector(std::initializer_list<T> elems) : SmallVector() {
+      reserve(elems.size());
+      for (auto &e : elems)
+        push_back(e);
+    }
+
+    SmallVector(const SmallVector &other) : SmallVector() {
+      reserve(other.size());
+      for (auto &e : other)
+        push_back(e);
+    }
+
+    SmallVector(SmallVector &&other) noexcept : SmallVector() {
+      take(other);
+    }
+
+    SmallVector &operator=(const SmallVector &other) {
+      if (this != &other) {
+        clear();
+        reserve(other.size());
+        for (auto &e : other)
+          push_back(e);
+      }
+      return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&other) noexcept {
+      if (this != &other) {
+        clear();
+        release();
+        take(other);
+      }
+      return *this;
+    }
+
+    ~SmallVector() {
+      clear();
+      release();
+    }
+
+    T       *data()       { return m_heap ? m_heap : inline_data(); }
+    const T *data() const { return m_heap ? m_heap : inline_data(); }
+
+    iterator       begin()       { return data(); }
+    iterator       end()         { return data() + m_size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end()   const { return data() + m_size; }
+
+    size_t size()  const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+
+    T       &operator[](size_t i)       { return data()[i]; }
+    const T &operator[](size_t i) const { return data()[i]; }
+
+    T       &front()       { return data()[0]; }
+    const T &front() const { return data()[0]; }
+    T       &back()        { return data()[m_size - 1]; }
+    const T &back()  const { return data()[m_size - 1]; }
+
+    void push_back(const T &e) { emplace_back(e); }
+    void push_back(T &&e)      { emplace_back(std::move(e)); }
+
+    template<class ...Args>
+    T &emplace_back(Args &&...args) {
+      if (m_size < m_cap)
+        return *new (data() + m_size++) T(std::forward<Args>(args)...);
+
+      // the arguments may point into this vector, make the new element
+      // before moving everything
+      T e(std::forward<Args>(args)...);
+      grow(m_cap * 2);
+      return *new (data() + m_size++) T(std::move(e));
+    }
+
+    void pop_back() { data()[--m_size].~T(); }
+
+    void reserve(size_t n) {
+      if (n > m_cap)
+        grow(n);
+    }
+
+    void clear() {
+      for (auto &e : *this)
+        e.~T();
+      m_size = 0;
+    }
+
+  private:
+    T *inline_data() { return reinterpret_cast<T *>(m_inline); }
+    const T *inline_data() const {
+      return reinterpret_cast<const T *>(m_inline);
+    }
+
+    void grow(size_t cap) {
+      T *heap = static_cast<T *>(::operator new(cap * sizeof(T)));
+
+      for (size_t i = 0; i < m_size; i++) {
+        new (heap + i) T(std::move(data()[i]));
+        data()[i].~T();
+      }
+
+      release();
+      m_heap = heap;
+      m_cap = cap;
+    }
+
+    // free the heap buffer, if any, the elements must be gone already
+    void release() {
+      ::operator delete(m_heap);
+      m_heap = nullptr;
+      m_cap = N;
+    }
+
+    // move other's elements here, this must be empty and inline
+    void take(SmallVector &other) {
+      if (other.m_heap) {
+        m_heap = other.m_heap;
+        m_size = other.m_size;
+        m_cap  = other.m_cap;
+
+        other.m_heap = nullptr;
+        other.m_size = 0;
+        other.m_cap  = N;
+        return;
+      }
+
+      for (auto &e : other)
+        new (inline_data() + m_size++) T(std::move(e));
+      other.clear();
+    }
+
+    alignas(T) unsigned char m_inline[N * sizeof(T)];
+    T *m_heap;
+    size_t m_size;
+    size_t m_cap;
+  };
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include "symbols.h"
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+namespace Parser {
+  namespace Symbols {
+    namespace {
+      // Texts live in fixed-size chunks that are never moved or freed,
+      // so str() can read them without taking the lock
+      constexpr unsigned int chunk_bits = 16;
+      constexpr uint32_t     chunk_size = 1 << chunk_bits;
+
+      std::atomic<std::string *> chunks[1 << (32 - chunk_bits)];
+      uint32_t count = 0;
+
+      std::mutex lock;
+      std::unordered_map<std::string_view, uint32_t> ids;
+
+      // lookups are mostly for names seen before, keep those off the lock
+      thread_local std::unordered_map<std::string_view, uint32_t> cache;
+    }
+
+    Symbol intern(std::string_view text) {
+      auto it = cache.find(text);
+      if (it != cache.end())
+        return it->second;
+
+      std::lock_guard<std::mutex> guard(lock);
+
+      auto id_it = ids.find(text);
+      if (id_it == ids.end()) {
+        uint32_t id = count++;
+
+        std::string *chunk = chunks[id >> chunk_bits].load();
+        if (chunk == NULL) {
+          chunk = new std::string[chunk_size];
+          chunks[id >> chunk_bits].store(chunk);
+        }
+
+        std::string &s = chunk[id & (chunk_size - 1)];
+        s = text;
+
+        id_it = ids.emplace(s, id).first;
+      }
+
+      cache.emplace(id_it->first, id_it->second);
+      return id_it->second;
+    }
+
+    std::string_view str(Symbol id) {
+      return chunks[id >> chunk_bits].load()[id & (chunk_size - 1)];
+    }
+  }
+}
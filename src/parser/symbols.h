@@ -0,0 +1,25 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <string_view>
+#include <cstdint>
+
+namespace Parser {
+
+  /// An interned string, equal ids are equal texts
+  using Symbol = uint32_t;
+
+  /// The table of interned strings
+
+  /// Interning the same text twice gives the same id, and the text of
+  /// an id never moves, so views returned by str() stay valid. Both are
+  /// safe to call from several threads.
+  namespace Symbols {
+    Symbol intern(std::string_view text);
+
+    std::string_view str(Symbol id);
+  }
+
+}
+
+#endif